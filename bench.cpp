@@ -0,0 +1,388 @@
+//
+// Throughput benchmark of the coders over a range of workloads, reporting JSON.
+//
+// Usage: bench_rans [--symbols N] [--repeat R] [--prob-bits B] [--file PATH] [--out PATH]
+//
+// Every workload is a text of N symbols over an alphabet of 2 to 4096 symbols: uniform, skewed (Zipf) or real data,
+// the bytes of PATH cut into bits, nibbles or bytes (the benchmark binary itself by default). Every variant encodes
+// and decodes it R times and keeps the fastest run. The per-symbol pdf and cdf variants work on fewer symbols, so that
+// their distribution matrix stays at about 16 MiB.
+//
+// MB/s count the raw text at one byte per symbol for alphabets of up to 256 symbols and two bytes above. Progress goes
+// to stderr, the JSON results to stdout or to the --out file.
+//
+
+#include "rANSCoder.h"
+#include "rANSByteCoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Number of distribution entries of the per-symbol pdf and cdf variants.
+#define BENCH_MATRIX_ENTRIES (1 << 22)
+
+typedef struct {
+    std::string distribution;
+    size_t alphabet;
+    std::vector<uint32_t> syms;
+} BenchWorkload;
+
+typedef struct {
+    std::string variant;
+    std::string distribution;
+    size_t alphabet;
+    uint32_t prob_bits;
+    size_t symbols;
+    size_t bytes;
+    double encode_seconds;
+    double decode_seconds;
+    bool ok;
+} BenchResult;
+
+static unsigned repeat = 3;
+
+// Runs f repeat times and returns the fastest run in seconds. prepare runs untimed before every run.
+static double best_of(const std::function<void()>& f, const std::function<void()>& prepare = nullptr) {
+    double best = 1e300;
+    for (unsigned r = 0; r < repeat; r++) {
+        if (prepare) prepare();
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(stop - start).count());
+    }
+    return best;
+}
+
+static BenchWorkload make_synthetic(const std::string& distribution, size_t alphabet, size_t n, std::mt19937& rng) {
+    BenchWorkload w = {distribution, alphabet, std::vector<uint32_t>(n)};
+    if (distribution == "uniform") {
+        std::uniform_int_distribution<uint32_t> d(0, (uint32_t) alphabet - 1);
+        for (auto& s : w.syms) s = d(rng);
+    } else {
+        std::vector<double> weights(alphabet);
+        for (size_t s = 0; s < alphabet; s++) weights[s] = 1.0 / std::pow((double) s + 1, 1.2);
+        std::discrete_distribution<uint32_t> d(weights.begin(), weights.end());
+        for (auto& s : w.syms) s = d(rng);
+    }
+    return w;
+}
+
+// Cuts the bytes of a file into symbols of bits bits, repeating the file until there are n symbols.
+static BenchWorkload make_real(const std::vector<uint8_t>& bytes, uint32_t bits, size_t n) {
+    BenchWorkload w = {"real", (size_t) 1 << bits, std::vector<uint32_t>(n)};
+    const uint32_t per_byte = 8 / bits;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b = bytes[(i / per_byte) % bytes.size()];
+        w.syms[i] = (b >> (bits * (i % per_byte))) & ((1u << bits) - 1);
+    }
+    return w;
+}
+
+static rANSModel model_of(const BenchWorkload& w, uint32_t prob_bits) {
+    std::vector<uint32_t> counts(w.alphabet);
+    for (uint32_t s : w.syms) counts[s]++;
+    return rANSModel(counts, prob_bits);
+}
+
+static BenchResult start_result(const char* variant, const BenchWorkload& w, uint32_t prob_bits, size_t n) {
+    BenchResult r = {variant, w.distribution, w.alphabet, prob_bits, n, 0, 0, 0, false};
+    return r;
+}
+
+static bool same(const uint32_t* a, const std::vector<uint32_t>& b, size_t n) {
+    return std::equal(a, a + n, b.begin());
+}
+
+static void run_workload(const BenchWorkload& w, uint32_t prob_bits, std::vector<BenchResult>& results) {
+    const size_t n = w.syms.size();
+    const uint32_t* syms = w.syms.data();
+    const rANSModel model = model_of(w, prob_bits);
+    const uint32_t* cdf = model.get_cdf();
+    const uint32_t* freqs = model.get_freqs();
+    std::vector<uint32_t> out(n);
+    std::vector<uint32_t> enc;
+
+    {
+        // the batch methods with a model
+        BenchResult r = start_result("model", w, prob_bits, n);
+        rANSCoder coder(1 << 11, prob_bits);
+        r.encode_seconds = best_of([&] { coder.encode_batch(syms, n, model); enc = coder.release_buffer(); });
+        r.decode_seconds = best_of([&] {
+            coder.init_dc_view(enc.data(), enc.size());
+            coder.decode_batch(model, n, out.data());
+        });
+        r.bytes = enc.size() * 4;
+        r.ok = same(out.data(), w.syms, n);
+        results.push_back(r);
+    }
+
+    {
+        // Rans64EncPut and Rans64DecAdvance on a std::vector, growing and shrinking it one word at a time
+        BenchResult r = start_result("raw_vector", w, prob_bits, n);
+        std::vector<uint32_t> vec, copy;
+        r.encode_seconds = best_of([&] {
+            vec.clear();
+            Rans64State state;
+            Rans64EncInit(&state);
+            for (size_t i = n; i > 0; i--) {
+                Rans64EncPut(&state, vec, cdf[syms[i-1]], freqs[syms[i-1]], prob_bits);
+            }
+            Rans64EncFlush(&state, vec);
+        });
+        r.bytes = vec.size() * 4;
+        // the decoder consumes the vector, so every run gets a fresh copy
+        r.decode_seconds = best_of([&] {
+            Rans64State state;
+            Rans64DecInit(&state, copy);
+            for (size_t i = 0; i < n; i++) {
+                uint32_t sym = model.find_symbol(Rans64DecGet(&state, prob_bits));
+                Rans64DecAdvance(&state, copy, cdf[sym], freqs[sym], prob_bits);
+                out[i] = sym;
+            }
+        }, [&] { copy = vec; });
+        r.ok = same(out.data(), w.syms, n);
+        results.push_back(r);
+    }
+
+    {
+        // Rans64EncPutFwd and Rans64DecAdvanceRev on a preallocated buffer, the same layout through a pointer
+        BenchResult r = start_result("raw_pointer", w, prob_bits, n);
+        std::vector<uint32_t> buf(n + 2);
+        size_t size = 0;
+        r.encode_seconds = best_of([&] {
+            Rans64State state;
+            Rans64EncInit(&state);
+            uint32_t* ptr = buf.data();
+            for (size_t i = n; i > 0; i--) {
+                Rans64EncPutFwd(&state, &ptr, cdf[syms[i-1]], freqs[syms[i-1]], prob_bits);
+            }
+            *ptr++ = (uint32_t) (state >> 32);
+            *ptr++ = (uint32_t) state;
+            size = ptr - buf.data();
+        });
+        r.decode_seconds = best_of([&] {
+            Rans64State state;
+            const uint32_t* ptr = buf.data() + size;
+            Rans64DecInitRev(&state, &ptr);
+            for (size_t i = 0; i < n; i++) {
+                uint32_t sym = model.find_symbol(Rans64DecGet(&state, prob_bits));
+                Rans64DecAdvanceRev(&state, &ptr, cdf[sym], freqs[sym], prob_bits);
+                out[i] = sym;
+            }
+        });
+        r.bytes = size * 4;
+        r.ok = same(out.data(), w.syms, n);
+        results.push_back(r);
+    }
+
+    {
+        // one call per symbol
+        BenchResult r = start_result("model_sym", w, prob_bits, n);
+        rANSCoder coder(1 << 11, prob_bits);
+        r.encode_seconds = best_of([&] {
+            for (size_t i = n; i > 0; i--) {
+                coder.encode_sym(syms[i-1], model);
+            }
+            enc = coder.release_buffer();
+        });
+        r.decode_seconds = best_of([&] {
+            coder.init_dc_view(enc.data(), enc.size());
+            for (size_t i = 0; i < n; i++) {
+                out[i] = coder.decode_sym(model);
+            }
+        });
+        r.bytes = enc.size() * 4;
+        r.ok = same(out.data(), w.syms, n);
+        results.push_back(r);
+    }
+
+    {
+        BenchResult r = start_result("interleaved4", w, prob_bits, n);
+        rANSCoder coder(1 << 11, prob_bits);
+        r.encode_seconds = best_of([&] { enc = coder.encode_interleaved(syms, n, model, 4); });
+        r.decode_seconds = best_of([&] { coder.decode_interleaved(enc.data(), enc.size(), model, n, out.data()); });
+        r.bytes = enc.size() * 4;
+        r.ok = same(out.data(), w.syms, n);
+        results.push_back(r);
+    }
+
+    if (prob_bits <= RANS_TANS_MAX_BITS) {
+        BenchResult r = start_result("tans", w, prob_bits, n);
+        rANSCoder coder(1 << 11, prob_bits);
+        rANSTansTable table(model);
+        r.encode_seconds = best_of([&] { enc = coder.encode_tans(syms, n, table); });
+        r.decode_seconds = best_of([&] { coder.decode_tans(enc.data(), enc.size(), table, n, out.data()); });
+        r.bytes = enc.size() * 4;
+        r.ok = same(out.data(), w.syms, n);
+        results.push_back(r);
+    }
+
+    if (prob_bits <= RANS_BYTE_MAX_BITS) {
+        BenchResult r = start_result("byte", w, prob_bits, n);
+        rANSByteCoder coder(prob_bits);
+        std::vector<uint8_t> bytes;
+        r.encode_seconds = best_of([&] { coder.encode_batch(syms, n, model); bytes = coder.release_buffer(); });
+        r.decode_seconds = best_of([&] {
+            coder.init_dc_view(bytes.data(), bytes.size());
+            coder.decode_batch(model, n, out.data());
+        });
+        r.bytes = bytes.size();
+        r.ok = same(out.data(), w.syms, n);
+        results.push_back(r);
+    }
+
+    // per-symbol distributions, all equal to the model so that the sizes compare
+    const size_t m = std::min(n, std::max<size_t>(1, BENCH_MATRIX_ENTRIES / (w.alphabet + 1)));
+
+    {
+        BenchResult r = start_result("pdf", w, prob_bits, m);
+        std::vector<float> pdfs(m * w.alphabet);
+        for (size_t i = 0; i < m; i++) {
+            for (size_t s = 0; s < w.alphabet; s++) {
+                pdfs[i * w.alphabet + s] = (float) freqs[s] / (1u << prob_bits);
+            }
+        }
+        rANSCoder coder(1 << 11, prob_bits);
+        r.encode_seconds = best_of([&] {
+            coder.encode_batch(syms, pdfs.data(), m, w.alphabet);
+            enc = coder.release_buffer();
+        });
+        r.decode_seconds = best_of([&] {
+            coder.init_dc_view(enc.data(), enc.size());
+            coder.decode_batch(pdfs.data(), m, w.alphabet, out.data());
+        });
+        r.bytes = enc.size() * 4;
+        r.ok = same(out.data(), w.syms, m);
+        results.push_back(r);
+    }
+
+    std::vector<uint32_t> cdfs(m * (w.alphabet + 1));
+    for (size_t i = 0; i < m; i++) {
+        std::copy(cdf, cdf + w.alphabet + 1, cdfs.begin() + i * (w.alphabet + 1));
+    }
+
+    {
+        BenchResult r = start_result("cdf", w, prob_bits, m);
+        rANSCoder coder(1 << 11, prob_bits);
+        r.encode_seconds = best_of([&] {
+            coder.encode_batch_cdf(syms, cdfs.data(), m, w.alphabet);
+            enc = coder.release_buffer();
+        });
+        r.decode_seconds = best_of([&] {
+            coder.init_dc_view(enc.data(), enc.size());
+            coder.decode_batch_cdf(cdfs.data(), m, w.alphabet, out.data());
+        });
+        r.bytes = enc.size() * 4;
+        r.ok = same(out.data(), w.syms, m);
+        results.push_back(r);
+    }
+}
+
+static double raw_megabytes(const BenchResult& r) {
+    return (double) r.symbols * (r.alphabet <= 256 ? 1 : 2) / 1e6;
+}
+
+static void write_json(std::ostream& os, const std::vector<BenchResult>& results, size_t n) {
+    os << "{\n  \"benchmark\": \"bench_rans\",\n  \"symbols\": " << n << ",\n  \"repeat\": " << repeat
+       << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        double mb = raw_megabytes(r);
+        os << "    {\"variant\": \"" << r.variant << "\", \"distribution\": \"" << r.distribution
+           << "\", \"alphabet\": " << r.alphabet << ", \"prob_bits\": " << r.prob_bits
+           << ", \"symbols\": " << r.symbols << ", \"bytes\": " << r.bytes
+           << ", \"bits_per_symbol\": " << (r.symbols ? 8.0 * r.bytes / r.symbols : 0)
+           << ", \"encode_ns_per_symbol\": " << r.encode_seconds * 1e9 / r.symbols
+           << ", \"decode_ns_per_symbol\": " << r.decode_seconds * 1e9 / r.symbols
+           << ", \"encode_mb_per_s\": " << mb / r.encode_seconds
+           << ", \"decode_mb_per_s\": " << mb / r.decode_seconds
+           << ", \"ok\": " << (r.ok ? "true" : "false") << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = 1 << 20;
+    uint32_t prob_bits = 14;
+    std::string file = argv[0];
+    std::string out_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "ERROR: Missing value of " << arg << "." << std::endl;
+            return 1;
+        }
+        if (arg == "--symbols") {
+            n = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--repeat") {
+            repeat = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--prob-bits") {
+            prob_bits = (uint32_t) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--file") {
+            file = argv[++i];
+        } else if (arg == "--out") {
+            out_path = argv[++i];
+        } else {
+            std::cerr << "ERROR: Unknown argument " << arg << "." << std::endl;
+            return 1;
+        }
+    }
+    if (n == 0 || repeat == 0 || prob_bits < 12 || prob_bits > 24) {
+        std::cerr << "ERROR: Needs at least one symbol and run, and prob_bits from 12 to 24." << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(file, std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.empty()) {
+        std::cerr << "ERROR: Could not read " << file << "." << std::endl;
+        return 1;
+    }
+
+    std::vector<BenchWorkload> workloads;
+    std::mt19937 rng(42);
+    for (size_t alphabet : {2, 16, 256, 4096}) {
+        workloads.push_back(make_synthetic("uniform", alphabet, n, rng));
+        workloads.push_back(make_synthetic("skewed", alphabet, n, rng));
+    }
+    for (uint32_t bits : {1, 4, 8}) {
+        workloads.push_back(make_real(bytes, bits, n));
+    }
+
+    std::vector<BenchResult> results;
+    for (const BenchWorkload& w : workloads) {
+        size_t first = results.size();
+        run_workload(w, prob_bits, results);
+        for (size_t i = first; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            fprintf(stderr, "%-8s %5zu %-14s %6.3f bits/sym  enc %7.2f ns/sym %8.1f MB/s  dec %7.2f ns/sym %8.1f MB/s%s\n",
+                    r.distribution.c_str(), r.alphabet, r.variant.c_str(), 8.0 * r.bytes / r.symbols,
+                    r.encode_seconds * 1e9 / r.symbols, raw_megabytes(r) / r.encode_seconds,
+                    r.decode_seconds * 1e9 / r.symbols, raw_megabytes(r) / r.decode_seconds,
+                    r.ok ? "" : "  FAILED");
+        }
+    }
+
+    if (out_path.empty()) {
+        write_json(std::cout, results, n);
+    } else {
+        std::ofstream out(out_path);
+        write_json(out, results, n);
+    }
+
+    for (const BenchResult& r : results) {
+        if (!r.ok) return 1;
+    }
+    return 0;
+}
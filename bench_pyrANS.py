@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Times the pyrANS bindings, to see the cost of a call on top of the C++ coder measured by bench_rans.
+
+Every method is called on arrays of 1 to 2**20 symbols. The time of a call on one symbol is the overhead of the
+binding, the time per symbol on large arrays should come close to the one of bench_rans. It also checks that the batch
+calls release the GIL. Progress goes to stderr, the JSON results to stdout or to the --out file.
+
+Usage: bench_pyrANS.py [--build-dir DIR] [--repeat R] [--alphabet K] [--out PATH]
+"""
+
+import argparse
+import json
+import sys
+import threading
+import time
+
+import numpy as np
+
+
+def best_of(repeat, f, prepare=None):
+    """Runs f repeat times and returns the fastest run in seconds. prepare runs untimed before every run."""
+    best = float("inf")
+    for _ in range(repeat):
+        if prepare:
+            prepare()
+        start = time.perf_counter()
+        f()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def releases_gil(f):
+    """Tells whether another Python thread runs while f does. The switch interval is raised for the call, so that a
+    thread waiting for the GIL only gets it when f releases it, not when the interpreter takes turns."""
+    ran = []
+    go = threading.Event()
+    other = threading.Thread(target=lambda: ran.append(go.wait()))
+    interval = sys.getswitchinterval()
+    other.start()
+    sys.setswitchinterval(10)
+    try:
+        go.set()
+        f()
+        released = bool(ran)
+    finally:
+        sys.setswitchinterval(interval)
+        other.join()
+    return released
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build-dir", default="_gate_build", help="directory holding the pyrANS module")
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--alphabet", type=int, default=256)
+    parser.add_argument("--out", help="file receiving the JSON results instead of stdout")
+    args = parser.parse_args()
+
+    sys.path.insert(0, args.build_dir)
+    import pyrANS
+
+    rng = np.random.default_rng(42)
+    weights = 1.0 / np.arange(1, args.alphabet + 1) ** 1.2
+    pdf = (weights / weights.sum()).astype(np.float32)
+    model = pyrANS.rANSModel.from_pdf(pdf)
+
+    results = []
+
+    def record(method, n, encode, decode):
+        per_call = {"encode": encode, "decode": decode}
+        entry = {"method": method, "symbols": n, "alphabet": args.alphabet}
+        for step, seconds in per_call.items():
+            entry[step + "_us_per_call"] = seconds * 1e6
+            entry[step + "_ns_per_symbol"] = seconds * 1e9 / n
+        results.append(entry)
+        print("%-18s %8d  enc %10.2f us %8.2f ns/sym  dec %10.2f us %8.2f ns/sym" % (
+            method, n, encode * 1e6, encode * 1e9 / n, decode * 1e6, decode * 1e9 / n), file=sys.stderr)
+
+    for n in [1, 16, 256, 4096, 65536, 1 << 20]:
+        syms = rng.choice(args.alphabet, size=n, p=pdf / pdf.sum()).astype(np.uint32)
+        coder = pyrANS.pyrANS(1 << 11, 14)
+        state = {}
+
+        def encode_model():
+            coder.encode_batch(syms, model)
+            state["data"] = coder.get_ec_buf()
+
+        def decode_model():
+            coder.init_dc(state["data"])
+            state["out"] = coder.decode_batch(model, n)
+
+        encode = best_of(args.repeat, encode_model)
+        decode = best_of(args.repeat, decode_model)
+        assert np.array_equal(state["out"], syms)
+        record("batch_model", n, encode, decode)
+
+        if n <= 4096:
+            def encode_sym():
+                for s in syms[::-1]:
+                    coder.encode_sym(int(s), model)
+                state["data"] = coder.get_ec_buf()
+
+            def decode_sym():
+                coder.init_dc(state["data"])
+                state["out"] = [coder.decode_sym(model) for _ in range(n)]
+
+            encode = best_of(args.repeat, encode_sym)
+            decode = best_of(args.repeat, decode_sym)
+            assert list(state["out"]) == list(syms)
+            record("sym_model", n, encode, decode)
+
+        if n * args.alphabet <= 1 << 22:
+            pdfs = np.broadcast_to(pdf, (n, args.alphabet))
+
+            def encode_pdf():
+                coder.encode_batch(syms, pdfs)
+                state["data"] = coder.get_ec_buf()
+
+            def decode_pdf():
+                coder.init_dc(state["data"])
+                state["out"] = coder.decode_batch(pdfs)
+
+            encode = best_of(args.repeat, encode_pdf)
+            decode = best_of(args.repeat, decode_pdf)
+            assert np.array_equal(state["out"], syms)
+            record("batch_pdf", n, encode, decode)
+
+        table = pyrANS.rANSTansTable(model)
+
+        def encode_tans():
+            state["data"] = coder.encode_tans(syms, table)
+
+        def decode_tans():
+            state["out"] = coder.decode_tans(state["data"], table, n)
+
+        encode = best_of(args.repeat, encode_tans)
+        decode = best_of(args.repeat, decode_tans)
+        assert np.array_equal(state["out"], syms)
+        record("tans", n, encode, decode)
+
+    # the batch calls release the GIL, a call on a single symbol keeps it
+    syms = rng.choice(args.alphabet, size=1 << 20, p=pdf / pdf.sum()).astype(np.uint32)
+    coder = pyrANS.pyrANS(1 << 11, 14)
+    gil = {"encode_batch": releases_gil(lambda: coder.encode_batch(syms, model))}
+    data = coder.get_ec_buf()
+    # handed over without a copy, and read-only so that init_dc reads it in place
+    assert not data.flags.owndata and not data.flags.writeable
+    coder.init_dc(data)
+    gil["decode_batch"] = releases_gil(lambda: coder.decode_batch(model, len(syms)))
+    gil["encode_sym"] = releases_gil(lambda: coder.encode_sym(int(syms[0]), model))
+    print("releases_gil       %s" % gil, file=sys.stderr)
+    assert gil["encode_batch"] and gil["decode_batch"] and not gil["encode_sym"]
+
+    report = {"benchmark": "bench_pyrANS", "repeat": args.repeat, "results": results, "releases_gil": gil}
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(report, f, indent=2)
+    else:
+        json.dump(report, sys.stdout, indent=2)
+        print()
+
+
+if __name__ == "__main__":
+    main()
@@ -2,6 +2,15 @@
 #include <vector> 
 #include <iostream>
 #include <rANSCoder.h>
+#include <rANSByteCoder.h>
+#include <rANSStream.h>
+#include <rANSMappedFile.h>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
 
 #define ALPH_SIZE 3
 #define BUFSIZE 200000
@@ -30,8 +39,1058 @@ int main__test(){
 }
 
 
+// Symbols below alphabet from a fixed pseudo-random source, symbol s drawn with probability test_pdf(alphabet)[s].
+std::vector<uint32_t> test_symbols(size_t n, uint32_t alphabet) {
+    std::vector<uint32_t> syms(n);
+    uint32_t x = 12345;
+    for (size_t i = 0; i < n; i++) {
+        x = x * 1103515245u + 12345u;
+        uint32_t r = (x >> 8) % (alphabet * alphabet);
+        syms[i] = alphabet - 1 - (uint32_t) std::sqrt((double) r);
+    }
+    return syms;
+}
+
+std::vector<float> test_pdf(uint32_t alphabet) {
+    std::vector<float> pdf(alphabet);
+    for (uint32_t s = 0; s < alphabet; s++) {
+        pdf[s] = (float) (2 * (alphabet - 1 - s) + 1) / (alphabet * alphabet);
+    }
+    return pdf;
+}
+
+// Prints the result of one of the checks below.
+bool report(const char* name, bool ok) {
+    std::cout << name << (ok ? ": Test passed" : ": Test failed") << std::endl;
+    return ok;
+}
+
+int main_context(){
+
+    std::vector<uint32_t> p = test_symbols(20000, 64);
+    rANSCoder mycoder;
+    bool ok = true;
+
+    for (uint32_t order = 1; order <= 2; order++) {
+        for (int adaptive = 0; adaptive <= 1; adaptive++) {
+            std::vector<uint32_t> data = mycoder.encode_context(p.data(), p.size(), 64, order, adaptive);
+            std::vector<uint32_t> res(rANSCoder::num_context_symbols(data.data(), data.size()));
+            mycoder.decode_context(data.data(), data.size(), res.data());
+            ok &= res == p;
+
+            // a payload missing words stops the decoder before the tables
+            std::vector<uint32_t> cut(data.begin(), data.end() - data.size() / 2);
+            cut.insert(cut.end(), data.end() - 2, data.end());
+            std::fill(res.begin(), res.end(), 0);
+            mycoder.decode_context(cut.data(), cut.size(), res.data());
+            ok &= res != p;
+        }
+    }
+
+    // an adaptive increment the encoder cannot write, and a static table listing a symbol twice, are rejected
+    std::vector<uint32_t> data = mycoder.encode_context(p.data(), p.size(), 64, 1, true);
+    data[RANS_CONTEXT_HEADER_WORDS] = 0x10000;
+    std::vector<uint32_t> res(p.size(), 7);
+    mycoder.decode_context(data.data(), data.size(), res.data());
+    ok &= res == std::vector<uint32_t>(p.size(), 7);
+
+    data = mycoder.encode_context(p.data(), p.size(), 64, 1, false);
+    data[RANS_CONTEXT_HEADER_WORDS + 4] = data[RANS_CONTEXT_HEADER_WORDS + 3];
+    mycoder.decode_context(data.data(), data.size(), res.data());
+    ok &= res == std::vector<uint32_t>(p.size(), 7);
+
+    // alphabets that do not fit into prob_bits are refused
+    rANSCoder small(1 << 11, 4);
+    ok &= small.encode_context(p.data(), p.size(), 64, 1, true).empty();
+
+    return report("context", ok);
+}
+
+int main_parametric(){
+
+    rANSParametricBank bank(RANS_LAPLACE, rANSParametricBank::log_scales(0.2f, 64.0f, 32));
+    std::vector<uint32_t> noise = test_symbols(20000, 32);
+    size_t n = noise.size();
+
+    std::vector<float> means(n);
+    std::vector<float> scales(n);
+    std::vector<int32_t> p(n);
+    for (size_t i = 0; i < n; i++) {
+        means[i] = (float) (i % 201) - 100.25f;
+        scales[i] = 0.2f * (float) (1 + i % 300);
+        int32_t residual = (int32_t) noise[i] * (i % 2 ? 1 : -1);
+        // every 1000th symbol is far outside its table and gets escaped
+        p[i] = (int32_t) std::floor(means[i] + 0.5f) + residual + (i % 1000 == 0 ? 1 << 20 : 0);
+    }
+    std::vector<uint32_t> indices(n);
+    bank.scale_indices(scales.data(), n, indices.data());
+
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch_parametric(p.data(), means.data(), indices.data(), n, bank);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+
+    rANSCoder mydec;
+    std::vector<int32_t> res(n);
+    mydec.init_dc(data);
+    mydec.decode_batch_parametric(means.data(), indices.data(), n, bank, res.data());
+    bool ok = res == p && mydec.words_left() == 0 && !mydec.decode_failed();
+
+    // without the first half of the words the decoder runs out before the last symbols
+    std::vector<uint32_t> cut(data.begin() + data.size() / 2, data.end());
+    mydec.init_dc(cut);
+    mydec.decode_batch_parametric(means.data(), indices.data(), n, bank, res.data());
+    ok &= mydec.decode_failed();
+
+    return report("parametric", ok);
+}
+
+int main_wide(){
+
+    std::vector<uint32_t> p = test_symbols(100003, 16);
+    rANSModel model(test_pdf(16));
+    rANSCoder mycoder;
+    bool ok = true;
+
+    for (uint32_t lanes = 8; lanes <= 16; lanes += 8) {
+        std::vector<uint32_t> data = mycoder.encode_wide(p.data(), p.size(), model, lanes);
+        std::vector<uint32_t> res(p.size());
+        ok &= rANSWideDecode(data.data(), data.size(), model, p.size(), res.data()) && res == p;
+
+        // decode_interleaved recognizes wide streams too
+        std::fill(res.begin(), res.end(), 0);
+        mycoder.decode_interleaved(data.data(), data.size(), model, p.size(), res.data());
+        ok &= res == p;
+
+        // a lane count other than 8 or 16, a payload larger than the stream, and half of the payload missing
+        std::vector<uint32_t> bad = data;
+        bad[0] = RANS_FORMAT_MARKER(RANS_FORMAT_WIDE, 12);
+        ok &= !rANSWideDecode(bad.data(), bad.size(), model, p.size(), res.data());
+        bad = data;
+        bad[1] = 0xffffffff;
+        ok &= !rANSWideDecode(bad.data(), bad.size(), model, p.size(), res.data());
+        bad = data;
+        bad[1] /= 2;
+        bad.resize(2 + lanes + (bad[1] + 1) / 2);
+        ok &= !rANSWideDecode(bad.data(), bad.size(), model, p.size(), res.data());
+    }
+
+    return report("wide", ok);
+}
+
+int main_blocks(){
+
+    std::vector<uint32_t> p = test_symbols(50001, 16);
+    std::vector<float> pdf = test_pdf(16);
+    rANSModel model(pdf);
+    std::vector<float> pdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        pdfs.insert(pdfs.end(), pdf.begin(), pdf.end());
+    }
+    rANSCoder mycoder;
+    mycoder.set_num_threads(4);
+    bool ok = true;
+
+    std::vector<uint32_t> data = mycoder.encode_blocks(p.data(), p.size(), model, 4096);
+    std::vector<uint32_t> res(rANSCoder::num_block_symbols(data.data(), data.size()));
+    mycoder.decode_blocks(data.data(), data.size(), model, res.data());
+    ok &= res == p;
+
+    // a range starting and ending inside blocks, and one running past the end
+    std::vector<uint32_t> tile(9000);
+    mycoder.decode_range(data.data(), data.size(), model, 10000, 19000, tile.data());
+    ok &= std::equal(tile.begin(), tile.end(), p.begin() + 10000);
+    mycoder.decode_range(data.data(), data.size(), model, 50000, 60000, tile.data());
+    ok &= tile[0] == p[50000];
+
+    std::vector<uint32_t> coded = mycoder.encode_blocks(p.data(), pdfs.data(), p.size(), 16, 5000);
+    std::fill(res.begin(), res.end(), 0);
+    mycoder.decode_blocks(coded.data(), coded.size(), pdfs.data(), 16, res.data());
+    ok &= res == p;
+    mycoder.decode_range(coded.data(), coded.size(), pdfs.data(), 16, 24999, 25001, tile.data());
+    ok &= tile[0] == p[24999] && tile[1] == p[25000];
+
+    // a header that does not add up leaves the output alone, a container missing its last words fails that block
+    std::vector<uint32_t> bad = data;
+    bad[4]++;
+    std::fill(res.begin(), res.end(), 7);
+    mycoder.decode_blocks(bad.data(), bad.size(), model, res.data());
+    ok &= res == std::vector<uint32_t>(p.size(), 7);
+    bad = data;
+    bad.resize(bad.size() - 2);
+    mycoder.decode_blocks(bad.data(), bad.size(), model, res.data());
+    ok &= res != p && std::equal(p.begin(), p.begin() + 4096, res.begin());
+
+    // a symbol count that wraps when rounded up to whole blocks, and a block offset that wraps past the payload
+    bad = {RANS_FORMAT_MARKER(RANS_FORMAT_BLOCKS, RANS_BLOCKS_VERSION), 0xffffffff, 0xffffffff, 2, 0};
+    ok &= rANSCoder::num_block_symbols(bad.data(), bad.size()) == 0;
+    std::fill(tile.begin(), tile.end(), 7);
+    mycoder.decode_range(bad.data(), bad.size(), model, 0, 1000, tile.data());
+    ok &= tile == std::vector<uint32_t>(tile.size(), 7);
+    bad = data;
+    bad[RANS_BLOCKS_HEADER_WORDS] = 0xfffffff0;
+    bad[RANS_BLOCKS_HEADER_WORDS + 1] = 0xffffffff;
+    mycoder.decode_range(bad.data(), bad.size(), model, 0, 1000, tile.data());
+    ok &= tile == std::vector<uint32_t>(tile.size(), 7);
+
+    return report("blocks", ok);
+}
+
+int main_adaptive(){
+
+    std::vector<uint32_t> p = test_symbols(30000, 32);
+    rANSAdaptiveModel model(32, 14, 24, 1 << 16, 512);
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch(p.data(), p.size(), model);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+
+    // the decoder's model starts over from the uniform distribution and learns the same symbols
+    rANSCoder mydec;
+    std::vector<uint32_t> res(p.size());
+    model.reset();
+    mydec.init_dc(data);
+    mydec.decode_batch(model, p.size(), res.data());
+    bool ok = res == p && mydec.words_left() == 0 && !mydec.decode_failed();
+
+    model.reset();
+    mydec.init_dc(data);
+    for (size_t i = 0; i < p.size(); i++) {
+        res[i] = mydec.decode_sym(model);
+    }
+    ok &= res == p && mydec.words_left() == 0;
+
+    // without the first half of the words the decoder runs out before the last symbols
+    std::vector<uint32_t> cut(data.begin() + data.size() / 2, data.end());
+    model.reset();
+    mydec.init_dc(cut);
+    mydec.decode_batch(model, p.size(), res.data());
+    ok &= mydec.decode_failed();
+
+    return report("adaptive", ok);
+}
+
+int main_byte(){
+
+    std::vector<uint32_t> p = test_symbols(5000, 16);
+    std::vector<float> pdf = test_pdf(16);
+    rANSModel model(pdf);
+    std::vector<float> pdfs;
+    std::vector<uint32_t> cdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        pdfs.insert(pdfs.end(), pdf.begin(), pdf.end());
+        cdfs.insert(cdfs.end(), model.get_cdf(), model.get_cdf() + 17);
+    }
+    rANSByteCoder mycoder;
+    rANSByteCoder mydec;
+    std::vector<uint32_t> res(p.size());
+    bool ok = true;
+
+    mycoder.encode_batch(p.data(), p.size(), model);
+    std::vector<uint8_t> data = mycoder.release_buffer();
+    ok &= mydec.init_dc_view(data.data(), data.size());
+    mydec.decode_batch(model, p.size(), res.data());
+    ok &= res == p && mydec.bytes_left() == 0 && !mydec.decode_failed();
+
+    mycoder.encode_batch(p.data(), pdfs.data(), p.size(), 16);
+    std::vector<uint8_t> coded = mycoder.release_buffer();
+    std::fill(res.begin(), res.end(), 0);
+    mydec.init_dc_view(coded.data(), coded.size());
+    mydec.decode_batch(pdfs.data(), p.size(), 16, res.data());
+    ok &= res == p;
+
+    mycoder.encode_batch_cdf(p.data(), cdfs.data(), p.size(), 16);
+    coded = mycoder.release_buffer();
+    std::fill(res.begin(), res.end(), 0);
+    mydec.init_dc_view(coded.data(), coded.size());
+    mydec.decode_batch_cdf(cdfs.data(), p.size(), 16, res.data());
+    ok &= res == p;
+
+    // a few symbols take a few bytes, no symbols none at all
+    mycoder.encode_batch(p.data(), 3, model);
+    coded = mycoder.release_buffer();
+    ok &= coded.size() <= 6;
+    mydec.init_dc_view(coded.data(), coded.size());
+    mydec.decode_batch(model, 3, res.data());
+    ok &= std::equal(p.begin(), p.begin() + 3, res.begin());
+    mycoder.encode_batch(p.data(), 0, model);
+    ok &= mycoder.release_buffer().empty();
+
+    // the decoder stops at the start of a message missing its first half, tells a message decoded with symbols to
+    // spare, and refuses one shorter than a state
+    std::vector<uint8_t> cut(data.begin() + data.size() / 2, data.end());
+    ok &= mydec.init_dc_view(cut.data(), cut.size());
+    mydec.decode_batch(model, p.size(), res.data());
+    ok &= mydec.decode_failed() && res != p;
+    mydec.init_dc_view(data.data(), data.size());
+    mydec.decode_batch(model, p.size() / 2, res.data());
+    ok &= !mydec.decode_failed() && mydec.bytes_left() > 0;
+    ok &= !mydec.init_dc_view(data.data(), 3) && mydec.decode_failed();
+
+    return report("byte", ok);
+}
+
+int main_stream(){
+
+    std::vector<uint32_t> p = test_symbols(10007, 16);
+    rANSModel model(test_pdf(16));
+    std::stringstream ss;
+    rANSStreamEncoder encoder(ss, model, 1000);
+    for (size_t i = 0; i < p.size(); i += 333) {
+        encoder.write(p.data() + i, std::min<size_t>(333, p.size() - i));
+    }
+    bool ok = encoder.finish() && encoder.get_num_symbols() == p.size();
+    std::string data = ss.str();
+
+    // frames are decoded across read calls of any size
+    std::istringstream is(data);
+    rANSStreamDecoder decoder(is, model);
+    std::vector<uint32_t> res(p.size() + 100);
+    size_t done = 0;
+    while (size_t got = decoder.read(res.data() + done, std::min<size_t>(777, res.size() - done))) {
+        done += got;
+    }
+    res.resize(done);
+    ok &= res == p && decoder.eof() && !decoder.fail();
+
+    // a frame claiming more or fewer symbols than it holds, and a stream cut short, fail the decoder
+    for (int delta = -100; delta <= 100; delta += 200) {
+        std::string bad = data;
+        uint32_t symbols;
+        std::memcpy(&symbols, &bad[4], 4);
+        symbols += delta;
+        std::memcpy(&bad[4], &symbols, 4);
+        std::istringstream bad_is(bad);
+        rANSStreamDecoder bad_decoder(bad_is, model);
+        res.resize(p.size());
+        bad_decoder.read(res.data(), res.size());
+        ok &= bad_decoder.fail();
+    }
+    std::istringstream cut_is(data.substr(0, data.size() - 20));
+    rANSStreamDecoder cut_decoder(cut_is, model);
+    ok &= cut_decoder.read(res.data(), res.size()) < p.size() && cut_decoder.fail();
+
+    return report("stream", ok);
+}
+
+// Writes words to a file in host byte order, as init_dc_mmap expects them.
+void write_words(const char* path, const uint32_t* words, size_t n, size_t extra_bytes = 0) {
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*) words, n * sizeof(uint32_t));
+    for (size_t i = 0; i < extra_bytes; i++) file.put(0);
+}
+
+int main_mmap(){
+
+    std::vector<uint32_t> p = test_symbols(50000, 16);
+    rANSModel model(test_pdf(16));
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch(p.data(), p.size(), model);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+    const char* path = "main_mmap.rans";
+
+    write_words(path, data.data(), data.size());
+    rANSCoder mydec;
+    std::vector<uint32_t> res(p.size());
+    bool ok = mydec.init_dc_mmap(path);
+    mydec.decode_batch(model, p.size(), res.data());
+    ok &= res == p && mydec.words_left() == 0 && !mydec.decode_failed();
+
+    // the mapping ends where the file does
+    write_words(path, data.data() + data.size() / 2, data.size() - data.size() / 2);
+    ok &= mydec.init_dc_mmap(path);
+    mydec.decode_batch(model, p.size(), res.data());
+    ok &= mydec.decode_failed();
+
+    // missing files, files that are not whole words and files too small to hold a state are refused
+    write_words(path, data.data(), data.size(), 1);
+    ok &= !mydec.init_dc_mmap(path);
+    write_words(path, data.data(), 1);
+    ok &= !mydec.init_dc_mmap(path);
+    std::remove(path);
+    ok &= !mydec.init_dc_mmap(path) && !rANSMappedFile(path).is_open();
+
+    return report("mmap", ok);
+}
+
+int main_static(){
+
+    std::vector<uint32_t> p = test_symbols(20000, 64);
+    rANSCoder mycoder;
+    bool ok = true;
+
+    // a model built from the symbols, the 100 first of which do not use the whole alphabet, and a given model
+    std::vector<std::vector<uint32_t> > texts = {p, std::vector<uint32_t>(p.begin(), p.begin() + 100)};
+    for (const std::vector<uint32_t>& text : texts) {
+        std::vector<uint32_t> data = mycoder.encode_static(text.data(), text.size(), 64);
+        std::vector<uint32_t> res(rANSCoder::num_static_symbols(data.data(), data.size()));
+        mycoder.decode_static(data.data(), data.size(), res.data());
+        ok &= res == text;
+    }
+    rANSModel model(test_pdf(64));
+    std::vector<uint32_t> data = mycoder.encode_static(p.data(), p.size(), model);
+    std::vector<uint32_t> res(rANSCoder::num_static_symbols(data.data(), data.size()));
+    mycoder.decode_static(data.data(), data.size(), res.data());
+    ok &= res == p;
+
+    // a header running past the stream and a table of no entries leave the output alone: the table starts with its
+    // number of entries, after 3 bytes of symbol count and a byte each of prob_bits and alphabet
+    std::vector<uint32_t> bad = data;
+    bad[1] = 0xffffffff;
+    ok &= rANSCoder::num_static_symbols(bad.data(), bad.size()) == 0;
+    std::fill(res.begin(), res.end(), 7);
+    mycoder.decode_static(bad.data(), bad.size(), res.data());
+    bad = data;
+    bad[RANS_STATIC_HEADER_WORDS + 1] &= ~0xff00u;
+    mycoder.decode_static(bad.data(), bad.size(), res.data());
+    ok &= res == std::vector<uint32_t>(p.size(), 7);
+
+    // a payload missing its first half stops at the table
+    bad = data;
+    size_t payload = RANS_STATIC_HEADER_WORDS + data[1];
+    bad.erase(bad.begin() + payload, bad.begin() + payload + (data.size() - payload) / 2);
+    mycoder.decode_static(bad.data(), bad.size(), res.data());
+    ok &= res != p;
+
+    // symbols outside of the alphabet are refused
+    ok &= mycoder.encode_static(p.data(), p.size(), 32).empty();
+
+    return report("static", ok);
+}
+
+int main_tans(){
+
+    std::vector<uint32_t> p = test_symbols(20000, 16);
+    std::vector<uint32_t> counts(16);
+    for (uint32_t sym : p) counts[sym]++;
+    bool ok = true;
+
+    // from the smallest table up to the largest
+    for (uint32_t bits : {RANS_TANS_MIN_BITS, 8, 14, RANS_TANS_MAX_BITS}) {
+        rANSModel model(counts, bits);
+        rANSTansTable table(model);
+        rANSCoder mycoder(1 << 11, bits);
+        std::vector<uint32_t> data = mycoder.encode_tans(p.data(), p.size(), table);
+        std::vector<uint32_t> res(p.size());
+        ok &= rANSTansDecode(data.data(), data.size(), table, p.size(), res.data()) && res == p;
+
+        // a stream missing its end, and one holding fewer bits than its header claims
+        std::vector<uint32_t> bad(data.begin(), data.end() - 2);
+        ok &= !rANSTansDecode(bad.data(), bad.size(), table, p.size(), res.data());
+        bad = data;
+        bad[2] = 1;
+        ok &= !rANSTansDecode(bad.data(), bad.size(), table, p.size(), res.data());
+    }
+
+    // tables too small for the spreading step are refused, and so is coding with them
+    rANSModel small(std::vector<uint32_t>{5, 1, 1}, 3);
+    rANSTansTable table(small);
+    rANSCoder mycoder(1 << 11, 3);
+    uint32_t syms[3] = {0, 1, 2};
+    ok &= table.size() == 0 && mycoder.encode_tans(syms, 3, table).empty();
+
+    return report("tans", ok);
+}
+
+int main_cdf(){
+
+    std::vector<uint32_t> p = test_symbols(10000, 16);
+    rANSModel model(test_pdf(16));
+    std::vector<uint32_t> cdf(model.get_cdf(), model.get_cdf() + 17);
+    std::vector<uint32_t> cdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        cdfs.insert(cdfs.end(), cdf.begin(), cdf.end());
+    }
+
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    for (size_t k = p.size(); k-- > 0;) {
+        mycoder.encode_sym_cdf(p[k], cdf.data(), 16);
+    }
+    // a symbol outside of the alphabet, a cdf not summing to 2^prob_bits and an empty bucket write nothing
+    std::vector<uint32_t> bad = cdf;
+    bad[16]--;
+    mycoder.encode_sym_cdf(16, cdf.data(), 16);
+    mycoder.encode_sym_cdf(0, bad.data(), 16);
+    bad = cdf;
+    bad[1] = bad[0];
+    mycoder.encode_sym_cdf(0, bad.data(), 16);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+
+    // the batch encoder writes the same stream
+    rANSCoder batch;
+    batch.init_ec();
+    batch.encode_batch_cdf(p.data(), cdfs.data(), p.size(), 16);
+    bool ok = batch.get_buffer() == data;
+
+    rANSCoder mydec;
+    std::vector<uint32_t> res(p.size());
+    mydec.init_dc(data);
+    for (size_t i = 0; i < p.size(); i++) {
+        res[i] = mydec.decode_sym_cdf(cdf.data(), 16);
+    }
+    ok &= res == p && mydec.words_left() == 0 && !mydec.decode_failed();
+
+    std::fill(res.begin(), res.end(), 0);
+    mydec.init_dc(data);
+    size_t words = mydec.words_left();
+    bad[1] = cdf[1];
+    bad[16]--;
+    ok &= mydec.decode_sym_cdf(bad.data(), 16) == 0 && mydec.words_left() == words;
+    mydec.decode_batch_cdf(cdfs.data(), p.size(), 16, res.data());
+    ok &= res == p && mydec.words_left() == 0;
+
+    return report("cdf", ok);
+}
+
+
+int main_batch(){
+
+    // a different distribution for every symbol, test_pdf rotated by the position
+    std::vector<uint32_t> p = test_symbols(5000, 20);
+    std::vector<float> pdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        std::vector<float> pdf = test_pdf(20);
+        std::rotate(pdf.begin(), pdf.begin() + i % 20, pdf.end());
+        pdfs.insert(pdfs.end(), pdf.begin(), pdf.end());
+    }
+    bool ok = true;
+
+    for (int legacy = 0; legacy <= 1; legacy++) {
+        // the batch writes the stream of encode_sym called from the last symbol to the first
+        rANSCoder single;
+        single.set_legacy_quantization(legacy);
+        single.init_ec();
+        for (size_t k = p.size(); k-- > 0;) {
+            single.encode_sym(p[k], std::vector<float>(pdfs.begin() + k * 20, pdfs.begin() + (k + 1) * 20));
+        }
+        std::vector<uint32_t> data = single.get_buffer();
+
+        rANSCoder batch;
+        batch.set_legacy_quantization(legacy);
+        batch.init_ec();
+        batch.encode_batch(p.data(), pdfs.data(), 0, 20);
+        batch.encode_batch(p.data(), pdfs.data(), p.size(), 20);
+        ok &= batch.get_buffer() == data;
+
+        // so decode_sym returns the symbols in their original order
+        rANSCoder mydec;
+        mydec.set_legacy_quantization(legacy);
+        mydec.init_dc(data);
+        std::vector<uint32_t> res(p.size());
+        for (size_t i = 0; i < p.size(); i++) {
+            res[i] = mydec.decode_sym(std::vector<float>(pdfs.begin() + i * 20, pdfs.begin() + (i + 1) * 20));
+        }
+        ok &= res == p && mydec.words_left() == 0;
+    }
+
+    // a symbol outside of the alphabet anywhere in the batch writes nothing
+    std::vector<uint32_t> bad = p;
+    bad[p.size() / 2] = 20;
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch(bad.data(), pdfs.data(), bad.size(), 20);
+    mycoder.encode_batch(p.data(), pdfs.data(), p.size(), 20);
+    rANSCoder reference;
+    reference.init_ec();
+    reference.encode_batch(p.data(), pdfs.data(), p.size(), 20);
+    ok &= mycoder.get_buffer() == reference.get_buffer();
+
+    return report("batch", ok);
+}
+
+
+int main_decode_batch(){
+
+    std::vector<uint32_t> p = test_symbols(5000, 20);
+    std::vector<float> pdf = test_pdf(20);
+    std::vector<float> pdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        pdfs.insert(pdfs.end(), pdf.begin(), pdf.end());
+    }
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch(p.data(), pdfs.data(), p.size(), 20);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+    bool ok = true;
+
+    // in the original order, in one call or split across calls and decode_sym, from a copy or a view
+    rANSCoder mydec;
+    std::vector<uint32_t> res(p.size());
+    mydec.init_dc(data);
+    mydec.decode_batch(pdfs.data(), p.size(), 20, res.data());
+    ok &= res == p && mydec.words_left() == 0 && !mydec.decode_failed();
+
+    std::fill(res.begin(), res.end(), 0);
+    mydec.init_dc_view(data.data(), data.size());
+    mydec.decode_batch(pdfs.data(), 1000, 20, res.data());
+    res[1000] = mydec.decode_sym(pdf);
+    mydec.decode_batch(pdfs.data(), p.size() - 1001, 20, res.data() + 1001);
+    ok &= res == p && mydec.words_left() == 0 && !mydec.decode_failed();
+
+    // a buffer missing its first words decodes the leading symbols, then fails and zeroes the rest
+    std::vector<uint32_t> cut(data.begin() + 100, data.end());
+    std::fill(res.begin(), res.end(), 7);
+    mydec.init_dc(cut);
+    mydec.decode_batch(pdfs.data(), p.size(), 20, res.data());
+    ok &= mydec.decode_failed() && std::equal(p.begin(), p.begin() + 1000, res.begin()) && res.back() == 0;
+
+    return report("decode_batch", ok);
+}
+
+
+int main_model(){
+
+    std::vector<uint32_t> p = test_symbols(5000, 20);
+    std::vector<float> pdf = test_pdf(20);
+    std::vector<float> pdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        pdfs.insert(pdfs.end(), pdf.begin(), pdf.end());
+    }
+    bool ok = true;
+
+    // a model codes like the pdf it was built from, under either quantization
+    for (int legacy = 0; legacy <= 1; legacy++) {
+        rANSModel model(pdf, 1 << 11, 14, legacy);
+        rANSCoder reference;
+        reference.set_legacy_quantization(legacy);
+        reference.init_ec();
+        reference.encode_batch(p.data(), pdfs.data(), p.size(), 20);
+        std::vector<uint32_t> data = reference.get_buffer();
+
+        rANSCoder mycoder;
+        mycoder.init_ec();
+        mycoder.encode_batch(p.data(), p.size(), model);
+        ok &= mycoder.get_buffer() == data;
+
+        rANSCoder single;
+        single.init_ec();
+        for (size_t k = p.size(); k-- > 0;) {
+            single.encode_sym(p[k], model);
+        }
+        ok &= single.get_buffer() == data;
+
+        rANSCoder mydec;
+        std::vector<uint32_t> res(p.size());
+        mydec.init_dc(data);
+        mydec.decode_batch(model, p.size(), res.data());
+        ok &= res == p && mydec.words_left() == 0;
+    }
+
+    // counts and frequencies: every symbol keeps a frequency, and the frequencies are taken as they are
+    rANSModel counted(std::vector<uint32_t>{1000, 10, 0, 1}, 14);
+    uint32_t total = 0;
+    for (size_t s = 0; s < counted.size(); s++) {
+        ok &= counted.get_freqs()[s] > 0;
+        total += counted.get_freqs()[s];
+    }
+    ok &= total == 1 << 14 && counted.get_cdf()[4] == 1 << 14;
+    rANSModel copied(counted.get_freqs(), counted.size(), 14);
+    ok &= std::equal(copied.get_cdf(), copied.get_cdf() + 5, counted.get_cdf());
+
+    // the compact table reads back into the same frequencies
+    rANSModel model(pdf);
+    std::vector<uint8_t> table;
+    model.write_table(table);
+    size_t used = 0;
+    rANSModel read(table.data(), table.size(), 20, 14, &used);
+    ok &= used == table.size() && std::equal(read.get_freqs(), read.get_freqs() + 20, model.get_freqs());
+    rANSModel cut(table.data(), table.size() - 1, 20, 14, &used);
+    ok &= used == 0 && cut.size() == 0;
+
+    // frequencies not summing to 2^prob_bits leave the model empty, a model of other prob_bits is refused
+    std::vector<uint32_t> freqs(model.get_freqs(), model.get_freqs() + 20);
+    freqs[0]++;
+    ok &= rANSModel(freqs.data(), 20, 14).size() == 0;
+    rANSCoder other(1 << 11, 12);
+    other.init_ec();
+    other.encode_batch(p.data(), p.size(), model);
+    ok &= other.get_buffer().empty();
+
+    return report("model", ok);
+}
+
+
+int main_lookup(){
+
+    std::vector<uint32_t> p = test_symbols(5000, 20);
+    std::vector<float> pdf = test_pdf(20);
+    bool ok = true;
+
+    // models up to RANS_MODEL_TABLE_MAX_BITS decode with the lookup table, larger ones search the cdf; both agree
+    for (uint32_t bits : {8, 14, 16, 17, 20}) {
+        rANSModel model(pdf, 1 << 11, bits);
+        const rANSDecSlot* slots = model.get_slots();
+        const uint32_t* cdf = model.get_cdf();
+        ok &= (slots != nullptr) == (bits <= RANS_MODEL_TABLE_MAX_BITS);
+        for (uint32_t c = 0; c < (uint32_t) 1 << bits; c++) {
+            uint32_t sym = rANSFindSymbol(cdf, 20, c);
+            ok &= cdf[sym] <= c && c < cdf[sym + 1] && model.find_symbol(c) == sym;
+            if (slots) {
+                ok &= slots[c].sym == sym && slots[c].start == cdf[sym] && slots[c].freq == cdf[sym + 1] - cdf[sym];
+            }
+        }
+
+        rANSCoder mycoder(1 << 11, bits);
+        mycoder.init_ec();
+        mycoder.encode_batch(p.data(), p.size(), model);
+        std::vector<uint32_t> data = mycoder.get_buffer();
+        std::vector<uint32_t> res(p.size());
+        mycoder.init_dc(data);
+        mycoder.decode_batch(model, p.size() - 1, res.data());
+        res.back() = mycoder.decode_sym(model);
+        ok &= res == p && mycoder.words_left() == 0;
+    }
+
+    // a single symbol holding all of 2^16 does not fit a table entry and is searched instead
+    rANSModel single(std::vector<uint32_t>{1}, 16);
+    ok &= single.get_slots() == nullptr && single.find_symbol(0xffff) == 0;
+
+    return report("lookup", ok);
+}
+
+
+int main_search(){
+
+    bool ok = true;
+    uint32_t x = 12345;
+
+    // every alphabet size around the bisection window and vector widths, with empty buckets and large totals
+    for (size_t size = 1; size <= 300; size++) {
+        std::vector<uint32_t> cdf(size + 1, 0);
+        for (size_t s = 0; s < size; s++) {
+            x = x * 1103515245u + 12345u;
+            cdf[s + 1] = cdf[s] + ((x >> 8) % 4 == 0 ? 0 : (x >> 8) % (1 << 20));
+        }
+        if (cdf[size] == 0) cdf[size] = 1;
+
+        for (uint32_t k = 0; k < 200; k++) {
+            x = x * 1103515245u + 12345u;
+            uint32_t cum_prob = k < 2 ? k * (cdf[size] - 1) : (x >> 4) % cdf[size];
+            uint32_t expected = 0;
+            while (cdf[expected + 1] <= cum_prob) expected++;
+            ok &= rANSFindSymbol(cdf.data(), size, cum_prob) == expected;
+        }
+    }
+
+    return report("search", ok);
+}
+
+
+int main_interleaved(){
+
+    std::vector<uint32_t> p = test_symbols(5003, 20);
+    std::vector<float> pdf = test_pdf(20);
+    bool ok = true;
+
+    // symbol counts that are and are not multiples of the states, fewer symbols than states, and a model without a
+    // lookup table
+    for (uint32_t bits : {14, 18}) {
+        rANSModel model(pdf, 1 << 11, bits);
+        rANSCoder mycoder(1 << 11, bits);
+        for (uint32_t ways : {1, 2, 4, 8}) {
+            for (size_t n : {(size_t) 0, (size_t) 3, (size_t) 4096, p.size()}) {
+                std::vector<uint32_t> data = mycoder.encode_interleaved(p.data(), n, model, ways);
+                std::vector<uint32_t> res(n);
+                mycoder.decode_interleaved(data.data(), data.size(), model, n, res.data());
+                ok &= std::equal(res.begin(), res.end(), p.begin()) &&
+                      data[0] == RANS_FORMAT_MARKER(RANS_FORMAT_INTERLEAVED, ways);
+            }
+        }
+    }
+
+    // a stream missing words, or too short for its states, is reported and not read past its start
+    rANSModel model(pdf);
+    rANSCoder mycoder;
+    std::vector<uint32_t> data = mycoder.encode_interleaved(p.data(), p.size(), model, 8);
+    std::vector<uint32_t> cut(data.begin(), data.begin() + 1);
+    cut.insert(cut.end(), data.begin() + 200, data.end());
+    std::vector<uint32_t> res(p.size());
+    mycoder.decode_interleaved(cut.data(), cut.size(), model, p.size(), res.data());
+    ok &= res != p;
+    cut.resize(10);
+    std::fill(res.begin(), res.end(), 7);
+    mycoder.decode_interleaved(cut.data(), cut.size(), model, p.size(), res.data());
+    ok &= res == std::vector<uint32_t>(p.size(), 7);
+
+    // unsupported numbers of states are refused
+    ok &= mycoder.encode_interleaved(p.data(), p.size(), model, 3).empty();
+
+    return report("interleaved", ok);
+}
+
+
+int main_range(){
+
+    std::vector<uint32_t> p = test_symbols(10500, 16);
+    rANSModel model(test_pdf(16));
+    rANSCoder mycoder;
+    mycoder.set_num_threads(3);
+    bool ok = true;
+
+    // every range starting or ending next to a block boundary, with the last block cut short
+    std::vector<uint32_t> data = mycoder.encode_blocks(p.data(), p.size(), model, 1000);
+    std::vector<uint32_t> tile(p.size() + 1);
+    for (size_t begin = 0; begin < p.size(); begin += 999) {
+        for (size_t end : {begin + 1, begin + 1000, begin + 2001, p.size()}) {
+            if (end > p.size()) continue;
+            std::fill(tile.begin(), tile.end(), 99);
+            mycoder.decode_range(data.data(), data.size(), model, begin, end, tile.data());
+            ok &= std::equal(p.begin() + begin, p.begin() + end, tile.begin()) && tile[end - begin] == 99;
+        }
+    }
+
+    // empty ranges and ranges past the end write nothing, an end past the end is clamped
+    std::fill(tile.begin(), tile.end(), 99);
+    mycoder.decode_range(data.data(), data.size(), model, 500, 500, tile.data());
+    mycoder.decode_range(data.data(), data.size(), model, 600, 500, tile.data());
+    mycoder.decode_range(data.data(), data.size(), model, p.size(), p.size() + 10, tile.data());
+    ok &= tile == std::vector<uint32_t>(tile.size(), 99);
+    mycoder.decode_range(data.data(), data.size(), model, p.size() - 5, p.size() + 10, tile.data());
+    ok &= std::equal(p.end() - 5, p.end(), tile.begin()) && tile[5] == 99;
+
+    // a container of a single block
+    data = mycoder.encode_blocks(p.data(), 700, model, 1000);
+    mycoder.decode_range(data.data(), data.size(), model, 100, 700, tile.data());
+    ok &= std::equal(p.begin() + 100, p.begin() + 700, tile.begin());
+
+    return report("range", ok);
+}
+
+
+int main_view(){
+
+    std::vector<uint32_t> p = test_symbols(5000, 16);
+    rANSModel model(test_pdf(16));
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch(p.data(), p.size(), model);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+    bool ok = true;
+
+    // the buffer handed out by release_buffer is the one get_buffer copies, and the coder starts over after it
+    rANSCoder released;
+    for (int k = 0; k < 2; k++) {
+        released.init_ec();
+        released.encode_batch(p.data(), p.size(), model);
+        ok &= released.release_buffer() == data;
+    }
+
+    // a view into the middle of other memory is decoded in place, without writing to it or reading outside of it
+    std::vector<uint32_t> memory(data.size() + 20, 0xffffffff);
+    std::copy(data.begin(), data.end(), memory.begin() + 10);
+    std::vector<uint32_t> before = memory;
+    std::vector<uint32_t> res(p.size());
+    rANSCoder mydec;
+    mydec.init_dc_view(memory.data() + 10, data.size());
+    ok &= mydec.words_left() == data.size() - 2;
+    mydec.decode_batch(model, p.size(), res.data());
+    ok &= res == p && mydec.words_left() == 0 && !mydec.decode_failed() && memory == before;
+
+    // a view missing its first words fails instead of reading before it
+    mydec.init_dc_view(memory.data() + 20, data.size() - 10);
+    mydec.decode_batch(model, p.size(), res.data());
+    ok &= mydec.decode_failed() && res.back() == 0 && memory == before;
+
+    // a view too small for the state is refused, and reads from it fail
+    mydec.init_dc_view(memory.data() + 10, 1);
+    ok &= mydec.decode_failed() && mydec.words_left() == 0 && mydec.decode_sym(model) == 0;
+
+    return report("view", ok);
+}
+
+
+int main_estimate(){
+
+    bool ok = true;
+
+    // the estimate is never below the output, so the batch encoders do not grow their buffer
+    for (uint32_t alphabet : {2, 16, 256}) {
+        for (size_t n : {(size_t) 0, (size_t) 1, (size_t) 1000, (size_t) 100000}) {
+            std::vector<uint32_t> p = test_symbols(n, alphabet);
+            rANSModel model(test_pdf(alphabet));
+            size_t estimate = model.estimate_words(p.data(), n);
+            rANSCoder mycoder;
+            mycoder.init_ec();
+            mycoder.encode_batch(p.data(), n, model);
+            size_t words = mycoder.get_buffer().size();
+            ok &= words <= estimate && estimate <= words + words / 10 + 2;
+        }
+    }
+
+    // legacy quantization of a small probability costs more than estimated, the buffer then grows while encoding
+    std::vector<uint32_t> p(200000, 1);
+    std::vector<float> pdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        pdfs.push_back(0.9991f);
+        pdfs.push_back(0.0009f);
+    }
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch(p.data(), pdfs.data(), p.size(), 2);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+    std::vector<uint32_t> res(p.size());
+    rANSCoder mydec;
+    mydec.init_dc(data);
+    mydec.decode_batch(pdfs.data(), p.size(), 2, res.data());
+    ok &= res == p && mydec.words_left() == 0;
+
+    return report("estimate", ok);
+}
+
+
+int main_quantize(){
+
+    bool ok = true;
+    uint32_t x = 12345;
+
+    // every frequency is at least 1 and they sum to 2^prob_bits, also for zeros, NaNs, tiny probabilities, pdfs not
+    // summing to 1, and as many symbols as there are frequencies
+    for (uint32_t bits : {8, 14, 16}) {
+        for (size_t size : {(size_t) 1, (size_t) 2, (size_t) 7, (size_t) 100, (size_t) 256}) {
+            std::vector<float> pdf(size);
+            for (size_t s = 0; s < size; s++) {
+                x = x * 1103515245u + 12345u;
+                pdf[s] = s % 5 == 1 ? 0.0f : s % 5 == 2 ? 1e-9f : (float) (x >> 8) / (1 << 24);
+            }
+            if (size > 3) pdf[3] = NAN;
+            std::vector<uint32_t> freqs(size);
+            std::vector<uint32_t> cdf(size + 1);
+            rANSQuantizePdf(pdf.data(), size, bits, freqs.data(), cdf.data());
+            ok &= cdf[0] == 0 && cdf[size] == (uint32_t) 1 << bits;
+            for (size_t s = 0; s < size; s++) {
+                ok &= freqs[s] >= 1 && cdf[s + 1] - cdf[s] == freqs[s];
+            }
+        }
+    }
+
+    // all of the frequencies taken by the symbols, and counts of 0 spread uniformly
+    std::vector<uint32_t> counts(256, 0);
+    std::vector<uint32_t> freqs(256);
+    std::vector<uint32_t> cdf(257);
+    rANSQuantizeCounts(counts.data(), 256, 8, freqs.data(), cdf.data());
+    ok &= freqs == std::vector<uint32_t>(256, 1);
+    rANSQuantizeCounts(counts.data(), 4, 8, freqs.data(), cdf.data());
+    ok &= std::equal(freqs.begin(), freqs.begin() + 4, std::vector<uint32_t>(4, 64).begin());
+
+    // a probability the legacy quantization rounds to 0 is refused there, and coded at full precision
+    std::vector<float> pdf = {0.000001f, 0.5f, 0.5f};
+    std::vector<uint32_t> p = {1, 0, 2, 0, 1};
+    std::vector<float> pdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        pdfs.insert(pdfs.end(), pdf.begin(), pdf.end());
+    }
+    rANSCoder legacy(1 << 20, 8);
+    legacy.init_ec();
+    legacy.encode_batch(p.data(), pdfs.data(), p.size(), 3);
+    ok &= legacy.get_buffer().empty();
+
+    rANSCoder mycoder(1 << 20, 8);
+    mycoder.set_legacy_quantization(false);
+    mycoder.init_ec();
+    mycoder.encode_batch(p.data(), pdfs.data(), p.size(), 3);
+    rANSCoder mydec(1 << 20, 8);
+    mydec.set_legacy_quantization(false);
+    mydec.init_dc(mycoder.get_buffer());
+    std::vector<uint32_t> res(p.size());
+    mydec.decode_batch(pdfs.data(), p.size(), 3, res.data());
+    ok &= res == p && mydec.words_left() == 0;
+
+    // the full precision quantization costs fewer bits than the legacy one for a skewed distribution
+    pdf = test_pdf(256);
+    rANSModel full(pdf);
+    rANSModel rounded(pdf, 1 << 11, 14, true);
+    double full_bits = 0, rounded_bits = 0;
+    for (size_t s = 0; s < 256; s++) {
+        full_bits -= pdf[s] * std::log2((double) full.get_freqs()[s] / (1 << 14));
+        if (rounded.get_freqs()[s] > 0) rounded_bits -= pdf[s] * std::log2((double) rounded.get_freqs()[s] / (1 << 14));
+    }
+    ok &= full_bits < rounded_bits;
+
+    return report("quantize", ok);
+}
+
+
+int main_stats(){
+
+    std::vector<uint32_t> p = test_symbols(10000, 16);
+    std::vector<float> pdf = test_pdf(16);
+    std::vector<float> pdfs;
+    for (size_t i = 0; i < p.size(); i++) {
+        pdfs.insert(pdfs.end(), pdf.begin(), pdf.end());
+    }
+    rANSCoder mycoder;
+    mycoder.init_ec();
+    mycoder.encode_batch(p.data(), pdfs.data(), p.size(), 16);
+    std::vector<uint32_t> data = mycoder.get_buffer();
+    rANSStats encoded = mycoder.stats();
+
+    rANSCoder mydec;
+    std::vector<uint32_t> res(p.size());
+    mydec.init_dc(data);
+    mydec.decode_batch(pdfs.data(), p.size(), 16, res.data());
+    rANSStats decoded = mydec.stats();
+    bool ok = res == p;
+
+    // a probability of 0 is clamped to the smallest frequency at full precision, and left out of the ideal cost
+    rANSCoder clamping;
+    clamping.set_legacy_quantization(false);
+    clamping.init_ec();
+    clamping.encode_sym(1, std::vector<float>{1.0f, 0.0f});
+    rANSStats clamped = clamping.stats();
+
+#ifdef RANS_STATS
+    // the renormalization words, without the final state, carry the model cost; test_pdf quantizes exactly
+    ok &= encoded.symbols == p.size() && encoded.words == data.size() - 2 && encoded.clamped == 0;
+    ok &= std::fabs(encoded.model_bits - 32.0 * encoded.words) < 64;
+    ok &= std::fabs(encoded.ideal_bits - encoded.model_bits) < 1e-3;
+    ok &= encoded.coding_cycles > 0 && encoded.quantize_cycles > 0;
+    ok &= decoded.symbols == encoded.symbols && decoded.words == encoded.words &&
+          std::fabs(decoded.model_bits - encoded.model_bits) < 1e-3;
+    ok &= clamped.symbols == 1 && clamped.clamped == 1 && clamped.ideal_bits == 0 && clamped.model_bits == 14;
+
+    mycoder.reset_stats();
+    ok &= mycoder.stats().symbols == 0 && mycoder.stats().model_bits == 0;
+#else
+    // compiled out, the counters stay 0
+    for (const rANSStats& counters : {encoded, decoded, clamped}) {
+        ok &= counters.symbols == 0 && counters.words == 0 && counters.ideal_bits == 0 && counters.model_bits == 0 &&
+              counters.clamped == 0 && counters.quantize_cycles == 0 && counters.coding_cycles == 0;
+    }
+#endif
+
+    return report("stats", ok);
+}
+
+
 int main(){
 
+    // round trips of the other coding modes, each printing its own result
+    bool checks = true;
+    checks &= main_context();
+    checks &= main_parametric();
+    checks &= main_wide();
+    checks &= main_blocks();
+    checks &= main_adaptive();
+    checks &= main_byte();
+    checks &= main_stream();
+    checks &= main_mmap();
+    checks &= main_static();
+    checks &= main_tans();
+    checks &= main_cdf();
+    checks &= main_batch();
+    checks &= main_decode_batch();
+    checks &= main_model();
+    checks &= main_lookup();
+    checks &= main_search();
+    checks &= main_interleaved();
+    checks &= main_range();
+    checks &= main_view();
+    checks &= main_estimate();
+    checks &= main_quantize();
+    checks &= main_stats();
+
     // set frequencies
     std::vector<float> pf(256, 0);
     pf.emplace(pf.begin(), 1);
@@ -65,20 +1124,22 @@ int main(){
     //std::cout << mydec.state << std::endl;
     //std::cout << mydec.vec.back() << mydec.vec.end()[-2] << std::endl;
 
-    std::vector<unsigned int> res;
+    std::vector<unsigned int> res(p.size());
 
-    for (int k = 0; k < p.size(); ++k) {
-        res.insert(res.begin(), mydec.decode_sym(pf));
+    for (size_t k = p.size(); k-- > 0;) {
+        res[k] = mydec.decode_sym(pf);
     }
 
-    if (p == res) {
+    if (p == res && checks) {
         std::cout << "Test passed" << std::endl;
+        return 0;
     } else {
         std::cout << "Test failed" << std::endl;
 
         for (int i = 0; i < p.size(); ++i) {
             std::cout << " " << res[i] << " " << p[i];
         }
+        return 1;
     }
 }
 
@@ -110,10 +1171,10 @@ int main_buffer(){
     rANSCoder mydec;
     mydec.init_dc(addr, size);
 
-    std::vector<unsigned int> res;
+    std::vector<unsigned int> res(p.size());
 
-    for (int k = 0; k < p.size(); ++k) {
-        res.insert(res.begin(), mydec.decode_sym(pf));
+    for (size_t k = p.size(); k-- > 0;) {
+        res[k] = mydec.decode_sym(pf);
     }
 
     if (p == res) {
@@ -146,10 +1207,10 @@ int main_basic(){
         mycoder.encode_sym(p[j], pf);
     }
 
-    std::vector<unsigned int> res;
+    std::vector<unsigned int> res(p.size());
 
-    for (int k = 0; k < p.size(); ++k) {
-        res.insert(res.begin(), mycoder.decode_sym(pf));
+    for (size_t k = p.size(); k-- > 0;) {
+        res[k] = mycoder.decode_sym(pf);
     }
 
     if (p == res) {
@@ -205,7 +1266,7 @@ int main_float() {
     uint32_t* out_end = out_buf + BUFSIZE;
     uint32_t* out_cur = out_end;
     Rans64State state;
-    std::vector<unsigned int> res;
+    std::vector<unsigned int> res(p.size());
 
     Rans64EncInit(&state);
 
@@ -219,7 +1280,7 @@ int main_float() {
     Rans64DecInit(&state, &out_cur);
     /***********************/
 
-    for (unsigned int i = 0; i<p.size(); i++) {
+    for (size_t i = p.size(); i-- > 0;) {
         uint32_t f = Rans64DecGet(&state, prob_bits);
         //printf("decoded freq: %d \n", f);
 
@@ -228,7 +1289,7 @@ int main_float() {
             j++;
         }
         //printf("decoded val: %d \n", j);
-        res.insert(res.begin(), j);
+        res[i] = j;
 
         Rans64DecAdvance(&state, &out_cur, cum_freqs[j], freqs[j], prob_bits);
     }
@@ -288,7 +1349,7 @@ int main_int() {
     uint32_t* out_end = out_buf + BUFSIZE;
     uint32_t* out_cur = out_end;
     Rans64State state;
-    std::vector<unsigned int> res;
+    std::vector<unsigned int> res(p.size());
 
     Rans64EncInit(&state);
 
@@ -302,7 +1363,7 @@ int main_int() {
     Rans64DecInit(&state, &out_cur);
     /***********************/
 
-    for (unsigned int i = 0; i<p.size(); i++) {
+    for (size_t i = p.size(); i-- > 0;) {
         uint32_t f = Rans64DecGet(&state, prob_bits);
         //printf("decoded freq: %d \n", f);
 
@@ -311,7 +1372,7 @@ int main_int() {
             j++;
         }
         //printf("decoded val: %d \n", j);
-        res.insert(res.begin(), j);
+        res[i] = j;
 
         Rans64DecAdvance(&state, &out_cur, cum_freqs[j], freqs[j], prob_bits);
     }
@@ -6,7 +6,14 @@
 #include <boost/python/module.hpp>
 #include <boost/python/args.hpp>
 #include <iostream>
+#include <algorithm>
+#include <utility>
+#include <string>
+#include <fstream>
+#include <memory>
 #include "rANSCoder.h"
+#include "rANSByteCoder.h"
+#include "rANSStream.h"
 
 namespace np = boost::python::numpy;
 namespace py = boost::python;
@@ -15,24 +22,196 @@ using namespace std;
 typedef unsigned char uchar;
 typedef unsigned long ulong;
 
+// Converts an ndarray to the given dtype and makes sure its memory is C-contiguous. Arrays that already qualify are
+// returned as they are, without a copy.
+static np::ndarray as_contiguous(np::ndarray const& a, np::dtype const& dt) {
+    int flags = a.get_flags();
+    if (np::equivalent(a.get_dtype(), dt) && (flags & np::ndarray::C_CONTIGUOUS) && (flags & np::ndarray::ALIGNED)) {
+        return a;
+    }
+
+    np::ndarray r = a.astype(dt);
+    if (!(r.get_flags() & np::ndarray::C_CONTIGUOUS)) {
+        r = r.copy();
+    }
+    return r;
+}
+
+template <typename T>
+static void free_buffer(PyObject* capsule) {
+    delete (std::vector<T>*)PyCapsule_GetPointer(capsule, NULL);
+}
+
+// Hands the vector over to NumPy without a copy. The array's base is a capsule owning the vector. The array is
+// read-only, so that passing it back to a decoder does not copy it either, see as_input.
+template <typename T>
+static np::ndarray to_ndarray(std::vector<T>&& data) {
+    std::vector<T>* buffer = new std::vector<T>(std::move(data));
+    PyObject* capsule = PyCapsule_New(buffer, NULL, free_buffer<T>);
+    if (!capsule) {
+        delete buffer;
+        py::throw_error_already_set();
+    }
+    py::object owner = py::object(py::handle<>(capsule));
+
+    np::ndarray out = np::from_data(buffer->data(), np::dtype::get_builtin<T>(),
+                                    py::make_tuple(buffer->size()),
+                                    py::make_tuple(sizeof(T)),
+                                    owner);
+    out.attr("setflags")(false);
+    return out;
+}
+
+// Releases the GIL for its lifetime, so that other Python threads run while a batch is coded. Nothing Python may be
+// touched in that scope: the arrays are converted and allocated before, and stay referenced by the calling frame.
+// The caller's arrays are passed through as_input, see there.
+class gil_release {
+
+    PyThreadState* saved;
+
+public:
+
+    gil_release() : saved(PyEval_SaveThread()) {}
+    ~gil_release() { PyEval_RestoreThread(saved); }
+
+};
+
+static void raise_value_error(const char* msg) {
+    PyErr_SetString(PyExc_ValueError, msg);
+    py::throw_error_already_set();
+}
+
+static void raise_io_error(const char* msg) {
+    PyErr_SetString(PyExc_IOError, msg);
+    py::throw_error_already_set();
+}
+
+// Makes a C-contiguous uint32 view of integer cdfs. Non-negative int32 values read the same as uint32, so int32
+// arrays are used in place like uint32 ones, other dtypes are converted.
+static np::ndarray as_cdf(np::ndarray const& a) {
+    int flags = a.get_flags();
+    if (np::equivalent(a.get_dtype(), np::dtype::get_builtin<int32_t>()) &&
+        (flags & np::ndarray::C_CONTIGUOUS) && (flags & np::ndarray::ALIGNED)) {
+        return a;
+    }
+    return as_contiguous(a, np::dtype::get_builtin<uint32_t>());
+}
+
+// Arrays the coder reads while the GIL is released. Another Python thread may write to the caller's array meanwhile,
+// and the coder relies on what it checked up front (symbols inside the alphabet, well formed cdfs, block offsets)
+// staying the same. So an array that would be used in place is copied when it is writeable. Read-only arrays, e.g.
+// np.frombuffer of bytes or an array with writeable cleared, are still used in place.
+static np::ndarray unshared(np::ndarray const& r, np::ndarray const& a) {
+    if (r.ptr() == a.ptr() && (r.get_flags() & np::ndarray::WRITEABLE)) {
+        return r.copy();
+    }
+    return r;
+}
+
+static np::ndarray as_input(np::ndarray const& a, np::dtype const& dt) {
+    return unshared(as_contiguous(a, dt), a);
+}
+
+static rANSModel model_from_pdf(np::ndarray pdf, uint32_t floatshift, uint32_t prob_bits, bool legacy) {
+    if (pdf.get_nd() != 1 || pdf.shape(0) < 1 || (uint64_t) pdf.shape(0) > ((uint64_t) 1 << prob_bits)) {
+        raise_value_error("rANSModel.from_pdf expects a pdf of shape (N,) with 1 <= N <= 2**prob_bits.");
+    }
+    np::ndarray pdf_as_float = as_contiguous(pdf, np::dtype::get_builtin<float>());
+    std::vector<float> vpdf((float*)pdf_as_float.get_data(), (float*)pdf_as_float.get_data()+pdf_as_float.shape(0));
+    return rANSModel(vpdf, floatshift, prob_bits, legacy);
+}
+
+static rANSModel model_from_counts(np::ndarray counts, uint32_t prob_bits, bool legacy) {
+    if (counts.get_nd() != 1 || counts.shape(0) < 1 || (uint64_t) counts.shape(0) > ((uint64_t) 1 << prob_bits)) {
+        raise_value_error("rANSModel.from_counts expects counts of shape (N,) with 1 <= N <= 2**prob_bits.");
+    }
+    np::ndarray counts_as_uint = as_contiguous(counts, np::dtype::get_builtin<uint32_t>());
+    std::vector<uint32_t> vcounts((uint32_t*)counts_as_uint.get_data(),
+                                  (uint32_t*)counts_as_uint.get_data()+counts_as_uint.shape(0));
+    return rANSModel(vcounts, prob_bits, legacy);
+}
+
+static rANSParametricBank bank_from_scales(std::string family, np::ndarray scales, uint32_t prob_bits,
+                                           double tail_mass) {
+    rANSFamily f = RANS_GAUSSIAN;
+    if (family == "laplace") {
+        f = RANS_LAPLACE;
+    } else if (family == "logistic") {
+        f = RANS_LOGISTIC;
+    } else if (family != "gaussian") {
+        raise_value_error("rANSParametricBank expects a family of 'gaussian', 'laplace' or 'logistic'.");
+    }
+    if (scales.get_nd() != 1 || scales.shape(0) < 1) {
+        raise_value_error("rANSParametricBank expects scales of shape (S,).");
+    }
+    np::ndarray scales_as_float = as_contiguous(scales, np::dtype::get_builtin<float>());
+    std::vector<float> vscales((float*)scales_as_float.get_data(),
+                               (float*)scales_as_float.get_data()+scales_as_float.shape(0));
+    return rANSParametricBank(f, vscales, prob_bits, tail_mass);
+}
+
+static np::ndarray bank_log_scales(float min_scale, float max_scale, size_t count) {
+    std::vector<float> vscales = rANSParametricBank::log_scales(min_scale, max_scale, count);
+    np::ndarray out = np::empty(py::make_tuple(count), np::dtype::get_builtin<float>());
+    std::copy(vscales.begin(), vscales.end(), (float*)out.get_data());
+    return out;
+}
+
+static np::ndarray bank_scale_indices(const rANSParametricBank& bank, np::ndarray scales) {
+    if (scales.get_nd() != 1) {
+        raise_value_error("scale_indices expects scales of shape (N,).");
+    }
+    np::ndarray scales_as_float = as_contiguous(scales, np::dtype::get_builtin<float>());
+    size_t n = scales_as_float.shape(0);
+    np::ndarray out = np::empty(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+    bank.scale_indices((float*)scales_as_float.get_data(), n, (uint32_t*)out.get_data());
+    return out;
+}
+
 class pyrANS : public rANSCoder{
 
+    // array the decoder reads from after init_dc
+    py::object dc_owner;
+
 public:
 
     void init_dc(np::ndarray r){
-        std::vector<uint32_t> vdc_bs = std::vector<uint32_t>((uint32_t*)r.get_data(),(uint32_t*)r.get_data()+r.shape(0));
-        rANSCoder::init_dc(vdc_bs);
+        if (r.get_nd() != 1) {
+            raise_value_error("init_dc expects a buffer of shape (N,).");
+        }
+        // decode straight from the array memory, keep a reference so it outlives the decoder
+        np::ndarray data_as_uint = as_input(r, np::dtype::get_builtin<uint32_t>());
+        dc_owner = data_as_uint;
+        rANSCoder::init_dc_view((const uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0));
     }
 
-    np::ndarray get_ec_buf(){
+    void init_dc_mmap(const std::string& path){
+        dc_owner = py::object();
+        if (!rANSCoder::init_dc_mmap(path.c_str())) {
+            raise_io_error("init_dc_mmap could not map the file, see the error printed above.");
+        }
+    }
 
-        std::vector<uint32_t> data = get_buffer();
+    np::ndarray get_ec_buf(){
+        return to_ndarray(release_buffer());
+    }
 
-        np::ndarray r = np::from_data(data.data(), np::dtype::get_builtin<uint32_t>(),
-                                      py::make_tuple(data.size()),
-                                      py::make_tuple(sizeof(uint32_t)),
-                                      py::object());
-        return  r.copy();
+    py::dict stats(){
+        rANSStats counters = rANSCoder::stats();
+        py::dict out;
+#ifdef RANS_STATS
+        out["enabled"] = true;
+#else
+        out["enabled"] = false;
+#endif
+        out["symbols"] = counters.symbols;
+        out["words"] = counters.words;
+        out["ideal_bits"] = counters.ideal_bits;
+        out["model_bits"] = counters.model_bits;
+        out["clamped"] = counters.clamped;
+        out["quantize_cycles"] = counters.quantize_cycles;
+        out["coding_cycles"] = counters.coding_cycles;
+        return out;
     }
 
 
@@ -42,20 +221,601 @@ public:
         rANSCoder::encode_sym(sym, vpdf);
     }
 
+    void encode_batch(np::ndarray syms, np::ndarray pdfs){
+        if (syms.get_nd() != 1 || pdfs.get_nd() != 2 || pdfs.shape(0) != syms.shape(0)) {
+            raise_value_error("encode_batch expects symbols of shape (N,) and pdfs of shape (N, K).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        np::ndarray pdfs_as_float = as_input(pdfs, np::dtype::get_builtin<float>());
+        {
+            gil_release nogil;
+            rANSCoder::encode_batch((uint32_t*)syms_as_uint.get_data(), (float*)pdfs_as_float.get_data(),
+                                    pdfs_as_float.shape(0), pdfs_as_float.shape(1));
+        }
+    }
+
+    void encode_sym_model(uint32_t sym, const rANSModel& model){
+        if (sym >= model.size()) {
+            raise_value_error("Symbol is outside of the model's alphabet.");
+        }
+        rANSCoder::encode_sym(sym, model);
+    }
+
+    void encode_batch_model(np::ndarray syms, const rANSModel& model){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_batch expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::encode_batch((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0), model);
+        }
+    }
+
+    void encode_batch_adaptive(np::ndarray syms, rANSAdaptiveModel& model){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_batch expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::encode_batch((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0), model);
+        }
+    }
+
+    uint32_t decode_sym_adaptive(rANSAdaptiveModel& model){
+        return rANSCoder::decode_sym(model);
+    }
+
+    np::ndarray decode_batch_adaptive(rANSAdaptiveModel& model, uint32_t n){
+        np::ndarray out = np::empty(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_batch(model, n, (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    uint32_t decode_sym_model(const rANSModel& model){
+        return rANSCoder::decode_sym(model);
+    }
+
+    np::ndarray decode_batch_model(const rANSModel& model, uint32_t n){
+        np::ndarray out = np::empty(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_batch(model, n, (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray encode_interleaved(np::ndarray syms, const rANSModel& model, uint32_t ways){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_interleaved expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_interleaved((uint32_t*)syms_as_uint.get_data(),
+                                                 syms_as_uint.shape(0), model, ways);
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray decode_interleaved(np::ndarray data, const rANSModel& model, uint32_t n){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        np::ndarray out = np::zeros(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_interleaved((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0), model, n,
+                                          (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray encode_wide(np::ndarray syms, const rANSModel& model, uint32_t lanes){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_wide expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_wide((uint32_t*)syms_as_uint.get_data(),
+                                          syms_as_uint.shape(0), model, lanes);
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray encode_blocks(np::ndarray syms, np::ndarray pdfs, size_t block_size){
+        if (syms.get_nd() != 1 || pdfs.get_nd() != 2 || pdfs.shape(0) != syms.shape(0)) {
+            raise_value_error("encode_blocks expects symbols of shape (N,) and pdfs of shape (N, K).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        np::ndarray pdfs_as_float = as_input(pdfs, np::dtype::get_builtin<float>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_blocks((uint32_t*)syms_as_uint.get_data(),
+                                            (float*)pdfs_as_float.get_data(),
+                                            pdfs_as_float.shape(0), pdfs_as_float.shape(1),
+                                            block_size);
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray encode_blocks_model(np::ndarray syms, const rANSModel& model, size_t block_size){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_blocks expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_blocks((uint32_t*)syms_as_uint.get_data(),
+                                            syms_as_uint.shape(0), model, block_size);
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray decode_blocks(np::ndarray data, np::ndarray pdfs){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        np::ndarray pdfs_as_float = as_input(pdfs, np::dtype::get_builtin<float>());
+        size_t n = rANSCoder::num_block_symbols((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0));
+        if (pdfs_as_float.get_nd() != 2 || (size_t)pdfs_as_float.shape(0) != n) {
+            raise_value_error("decode_blocks expects pdfs of shape (N, K), N being the number of encoded symbols.");
+        }
+        np::ndarray out = np::zeros(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_blocks((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0),
+                                     (float*)pdfs_as_float.get_data(), pdfs_as_float.shape(1),
+                                     (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray decode_blocks_model(np::ndarray data, const rANSModel& model){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        size_t n = rANSCoder::num_block_symbols((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0));
+        np::ndarray out = np::zeros(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_blocks((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0), model,
+                                     (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray decode_range(np::ndarray data, np::ndarray pdfs, size_t begin, size_t end){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        np::ndarray pdfs_as_float = as_input(pdfs, np::dtype::get_builtin<float>());
+        size_t n = rANSCoder::num_block_symbols((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0));
+        if (pdfs_as_float.get_nd() != 2 || (size_t)pdfs_as_float.shape(0) != n) {
+            raise_value_error("decode_range expects pdfs of shape (N, K), N being the number of encoded symbols.");
+        }
+        end = std::min(end, n);
+        begin = std::min(begin, end);
+        np::ndarray out = np::zeros(py::make_tuple(end - begin), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_range((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0),
+                                    (float*)pdfs_as_float.get_data(), pdfs_as_float.shape(1), begin, end,
+                                    (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray decode_range_model(np::ndarray data, const rANSModel& model, size_t begin, size_t end){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        size_t n = rANSCoder::num_block_symbols((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0));
+        end = std::min(end, n);
+        begin = std::min(begin, end);
+        np::ndarray out = np::zeros(py::make_tuple(end - begin), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_range((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0), model, begin, end,
+                                    (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    void encode_batch_parametric(np::ndarray syms, np::ndarray means, np::ndarray scale_indices,
+                                 const rANSParametricBank& bank){
+        if (syms.get_nd() != 1 || means.get_nd() != 1 || scale_indices.get_nd() != 1 ||
+            means.shape(0) != syms.shape(0) || scale_indices.shape(0) != syms.shape(0)) {
+            raise_value_error("encode_batch_parametric expects symbols, means and scale_indices of shape (N,).");
+        }
+        np::ndarray syms_as_int = as_input(syms, np::dtype::get_builtin<int32_t>());
+        np::ndarray means_as_float = as_input(means, np::dtype::get_builtin<float>());
+        np::ndarray indices_as_uint = as_input(scale_indices, np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::encode_batch_parametric((int32_t*)syms_as_int.get_data(), (float*)means_as_float.get_data(),
+                                               (uint32_t*)indices_as_uint.get_data(), syms_as_int.shape(0), bank);
+        }
+    }
+
+    np::ndarray decode_batch_parametric(np::ndarray means, np::ndarray scale_indices, const rANSParametricBank& bank){
+        if (means.get_nd() != 1 || scale_indices.get_nd() != 1 || scale_indices.shape(0) != means.shape(0)) {
+            raise_value_error("decode_batch_parametric expects means and scale_indices of shape (N,).");
+        }
+        np::ndarray means_as_float = as_input(means, np::dtype::get_builtin<float>());
+        np::ndarray indices_as_uint = as_input(scale_indices, np::dtype::get_builtin<uint32_t>());
+        np::ndarray out = np::zeros(py::make_tuple(means_as_float.shape(0)), np::dtype::get_builtin<int32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_batch_parametric((float*)means_as_float.get_data(),
+                                               (uint32_t*)indices_as_uint.get_data(), means_as_float.shape(0), bank,
+                                               (int32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray encode_tans(np::ndarray syms, const rANSTansTable& table){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_tans expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_tans((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0), table);
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray decode_tans(np::ndarray data, const rANSTansTable& table, uint32_t n){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        np::ndarray out = np::zeros(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_tans((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0), table, n,
+                                   (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray encode_context(np::ndarray syms, size_t alphabet, uint32_t order, bool adaptive){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_context expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_context((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0), alphabet,
+                                             order, adaptive);
+        }
+        if (data.empty()) {
+            raise_value_error("encode_context expects an order of 1 or 2, an alphabet of at most 1024 symbols containing all symbols and prob_bits of at most 16.");
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray decode_context(np::ndarray data){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        size_t n = rANSCoder::num_context_symbols((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0));
+        np::ndarray out = np::zeros(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_context((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0),
+                                      (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray encode_static(np::ndarray syms, size_t alphabet){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_static expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_static((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0), alphabet);
+        }
+        if (data.empty()) {
+            raise_value_error("encode_static expects an alphabet containing all symbols.");
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray encode_static_model(np::ndarray syms, const rANSModel& model){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_static expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        std::vector<uint32_t> data;
+        {
+            gil_release nogil;
+            data = rANSCoder::encode_static((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0), model);
+        }
+        if (data.empty()) {
+            raise_value_error("encode_static expects a model with the coder's prob_bits giving all symbols a frequency.");
+        }
+        return to_ndarray(std::move(data));
+    }
+
+    np::ndarray decode_static(np::ndarray data){
+        np::ndarray data_as_uint = as_input(data, np::dtype::get_builtin<uint32_t>());
+        size_t n = rANSCoder::num_static_symbols((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0));
+        np::ndarray out = np::zeros(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_static((uint32_t*)data_as_uint.get_data(), data_as_uint.shape(0),
+                                     (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
     uint32_t decode_sym(np::ndarray pdf){
         np::ndarray pdf_as_float = pdf.astype(np::dtype::get_builtin<float>());
         auto vpdf = std::vector<float>((float*)pdf_as_float.get_data(),(float*)pdf_as_float.get_data()+pdf_as_float.shape(0));
         return rANSCoder::decode_sym(vpdf);
     }
 
-    pyrANS(const unsigned int& floatshift, const unsigned int& prob_bits) {
-        rANSCoder(floatshift, prob_bits);
+    np::ndarray decode_batch(np::ndarray pdfs){
+        if (pdfs.get_nd() != 2) {
+            raise_value_error("decode_batch expects pdfs of shape (N, K).");
+        }
+        np::ndarray pdfs_as_float = as_input(pdfs, np::dtype::get_builtin<float>());
+        np::ndarray out = np::empty(py::make_tuple(pdfs_as_float.shape(0)), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_batch((float*)pdfs_as_float.get_data(), pdfs_as_float.shape(0), pdfs_as_float.shape(1),
+                                    (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    void encode_sym_cdf(uint32_t sym, np::ndarray cdf){
+        if (cdf.get_nd() != 1 || sym + 1 >= (size_t)cdf.shape(0)) {
+            raise_value_error("encode_sym_cdf expects a cdf of shape (K+1,) and a symbol below K.");
+        }
+        np::ndarray cdf_as_uint = as_cdf(cdf);
+        rANSCoder::encode_sym_cdf(sym, (uint32_t*)cdf_as_uint.get_data(), cdf_as_uint.shape(0) - 1);
+    }
+
+    void encode_batch_cdf(np::ndarray syms, np::ndarray cdfs){
+        if (syms.get_nd() != 1 || cdfs.get_nd() != 2 || cdfs.shape(0) != syms.shape(0) || cdfs.shape(1) < 2) {
+            raise_value_error("encode_batch_cdf expects symbols of shape (N,) and cdfs of shape (N, K+1).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        np::ndarray cdfs_as_uint = unshared(as_cdf(cdfs), cdfs);
+        {
+            gil_release nogil;
+            rANSCoder::encode_batch_cdf((uint32_t*)syms_as_uint.get_data(), (uint32_t*)cdfs_as_uint.get_data(),
+                                        cdfs_as_uint.shape(0), cdfs_as_uint.shape(1) - 1);
+        }
+    }
+
+    uint32_t decode_sym_cdf(np::ndarray cdf){
+        if (cdf.get_nd() != 1 || cdf.shape(0) < 2) {
+            raise_value_error("decode_sym_cdf expects a cdf of shape (K+1,).");
+        }
+        np::ndarray cdf_as_uint = as_cdf(cdf);
+        return rANSCoder::decode_sym_cdf((uint32_t*)cdf_as_uint.get_data(), cdf_as_uint.shape(0) - 1);
+    }
+
+    np::ndarray decode_batch_cdf(np::ndarray cdfs){
+        if (cdfs.get_nd() != 2 || cdfs.shape(1) < 2) {
+            raise_value_error("decode_batch_cdf expects cdfs of shape (N, K+1).");
+        }
+        np::ndarray cdfs_as_uint = unshared(as_cdf(cdfs), cdfs);
+        np::ndarray out = np::zeros(py::make_tuple(cdfs_as_uint.shape(0)), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSCoder::decode_batch_cdf((uint32_t*)cdfs_as_uint.get_data(), cdfs_as_uint.shape(0),
+                                        cdfs_as_uint.shape(1) - 1, (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    pyrANS(const unsigned int& floatshift, const unsigned int& prob_bits) : rANSCoder(floatshift, prob_bits) {}
+
+    pyrANS() : rANSCoder() {}
+
+};
+
+
+class pyrANSByte : public rANSByteCoder{
+
+    // message the decoder reads from after init_dc
+    py::object dc_owner;
+
+public:
+
+    explicit pyrANSByte(uint32_t prob_bits) : rANSByteCoder(prob_bits) {}
+
+    bool init_dc(py::object data){
+        if (PyBytes_Check(data.ptr())) {
+            dc_owner = data;
+            return rANSByteCoder::init_dc_view((const uint8_t*)PyBytes_AS_STRING(data.ptr()),
+                                               PyBytes_GET_SIZE(data.ptr()));
+        }
+        np::ndarray r = py::extract<np::ndarray>(data);
+        if (r.get_nd() != 1) {
+            raise_value_error("init_dc expects bytes or a buffer of shape (N,).");
+        }
+        np::ndarray data_as_uint8 = as_input(r, np::dtype::get_builtin<uint8_t>());
+        dc_owner = data_as_uint8;
+        return rANSByteCoder::init_dc_view((const uint8_t*)data_as_uint8.get_data(), data_as_uint8.shape(0));
+    }
+
+    np::ndarray get_ec_buf(){
+        return to_ndarray(release_buffer());
+    }
+
+    py::object get_ec_bytes(){
+        std::vector<uint8_t> data = release_buffer();
+        PyObject* bytes = PyBytes_FromStringAndSize((const char*)data.data(), data.size());
+        if (!bytes) {
+            py::throw_error_already_set();
+        }
+        return py::object(py::handle<>(bytes));
+    }
+
+    void encode_batch(np::ndarray syms, np::ndarray pdfs){
+        if (syms.get_nd() != 1 || pdfs.get_nd() != 2 || pdfs.shape(0) != syms.shape(0)) {
+            raise_value_error("encode_batch expects symbols of shape (N,) and pdfs of shape (N, K).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        np::ndarray pdfs_as_float = as_input(pdfs, np::dtype::get_builtin<float>());
+        {
+            gil_release nogil;
+            rANSByteCoder::encode_batch((uint32_t*)syms_as_uint.get_data(), (float*)pdfs_as_float.get_data(),
+                                        pdfs_as_float.shape(0), pdfs_as_float.shape(1));
+        }
+    }
+
+    void encode_batch_model(np::ndarray syms, const rANSModel& model){
+        if (syms.get_nd() != 1) {
+            raise_value_error("encode_batch expects symbols of shape (N,).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSByteCoder::encode_batch((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0), model);
+        }
+    }
+
+    void encode_batch_cdf(np::ndarray syms, np::ndarray cdfs){
+        if (syms.get_nd() != 1 || cdfs.get_nd() != 2 || cdfs.shape(0) != syms.shape(0) || cdfs.shape(1) < 2) {
+            raise_value_error("encode_batch_cdf expects symbols of shape (N,) and cdfs of shape (N, K+1).");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        np::ndarray cdfs_as_uint = unshared(as_cdf(cdfs), cdfs);
+        {
+            gil_release nogil;
+            rANSByteCoder::encode_batch_cdf((uint32_t*)syms_as_uint.get_data(), (uint32_t*)cdfs_as_uint.get_data(),
+                                            cdfs_as_uint.shape(0), cdfs_as_uint.shape(1) - 1);
+        }
+    }
+
+    np::ndarray decode_batch(np::ndarray pdfs){
+        if (pdfs.get_nd() != 2) {
+            raise_value_error("decode_batch expects pdfs of shape (N, K).");
+        }
+        np::ndarray pdfs_as_float = as_input(pdfs, np::dtype::get_builtin<float>());
+        np::ndarray out = np::empty(py::make_tuple(pdfs_as_float.shape(0)), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSByteCoder::decode_batch((float*)pdfs_as_float.get_data(), pdfs_as_float.shape(0),
+                                        pdfs_as_float.shape(1), (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray decode_batch_model(const rANSModel& model, uint32_t n){
+        np::ndarray out = np::empty(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSByteCoder::decode_batch(model, n, (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+    np::ndarray decode_batch_cdf(np::ndarray cdfs){
+        if (cdfs.get_nd() != 2 || cdfs.shape(1) < 2) {
+            raise_value_error("decode_batch_cdf expects cdfs of shape (N, K+1).");
+        }
+        np::ndarray cdfs_as_uint = unshared(as_cdf(cdfs), cdfs);
+        np::ndarray out = np::empty(py::make_tuple(cdfs_as_uint.shape(0)), np::dtype::get_builtin<uint32_t>());
+        {
+            gil_release nogil;
+            rANSByteCoder::decode_batch_cdf((uint32_t*)cdfs_as_uint.get_data(), cdfs_as_uint.shape(0),
+                                            cdfs_as_uint.shape(1) - 1, (uint32_t*)out.get_data());
+        }
+        return out;
+    }
+
+};
+
+// Streaming encoder writing to a file it owns.
+class pyrANSStreamWriter {
+
+    std::ofstream file;
+    std::unique_ptr<rANSStreamEncoder> encoder;
+
+public:
+
+    pyrANSStreamWriter(const std::string& path, const rANSModel& model, size_t window_size)
+            : file(path, std::ios::binary | std::ios::trunc) {
+        if (!file) {
+            raise_io_error("rANSStreamWriter could not open the file.");
+        }
+        encoder.reset(new rANSStreamEncoder(file, model, window_size));
+    }
+
+    void write(np::ndarray syms){
+        if (syms.get_nd() != 1) {
+            raise_value_error("write expects symbols of shape (N,).");
+        }
+        if (!encoder) {
+            raise_value_error("Writing to a closed rANSStreamWriter.");
+        }
+        np::ndarray syms_as_uint = as_input(syms, np::dtype::get_builtin<uint32_t>());
+        bool ok;
+        {
+            gil_release nogil;
+            ok = encoder->write((uint32_t*)syms_as_uint.get_data(), syms_as_uint.shape(0));
+        }
+        if (!ok) {
+            raise_value_error("rANSStreamWriter could not write the symbols, see the error printed above.");
+        }
     }
 
-    pyrANS() {
-        rANSCoder();
+    void close(){
+        if (!encoder) return;
+        bool ok = encoder->finish();
+        encoder.reset();
+        file.close();
+        if (!ok) {
+            raise_io_error("rANSStreamWriter could not finish the stream.");
+        }
     }
 
+    uint64_t num_symbols() const { return encoder ? encoder->get_num_symbols() : 0; }
+
+};
+
+// Streaming decoder reading from a file it owns.
+class pyrANSStreamReader {
+
+    std::ifstream file;
+    std::unique_ptr<rANSStreamDecoder> decoder;
+
+public:
+
+    pyrANSStreamReader(const std::string& path, const rANSModel& model) : file(path, std::ios::binary) {
+        if (!file) {
+            raise_io_error("rANSStreamReader could not open the file.");
+        }
+        decoder.reset(new rANSStreamDecoder(file, model));
+    }
+
+    np::ndarray read(size_t n){
+        np::ndarray out = np::empty(py::make_tuple(n), np::dtype::get_builtin<uint32_t>());
+        size_t got;
+        {
+            gil_release nogil;
+            got = decoder->read((uint32_t*)out.get_data(), n);
+        }
+        if (decoder->fail()) {
+            raise_value_error("rANSStreamReader found a malformed or truncated stream.");
+        }
+        if (got < n) {
+            np::ndarray tail = np::empty(py::make_tuple(got), np::dtype::get_builtin<uint32_t>());
+            std::copy((uint32_t*)out.get_data(), (uint32_t*)out.get_data() + got, (uint32_t*)tail.get_data());
+            return tail;
+        }
+        return out;
+    }
+
+    bool eof() const { return decoder->eof(); }
+
 };
 
 
@@ -64,14 +824,102 @@ BOOST_PYTHON_MODULE(pyrANS)
     Py_Initialize();
     np::initialize();
 
+    py::class_<rANSModel>("rANSModel", "Precomputed quantized distribution for coding many symbols with the same pdf.", py::no_init)
+        .def("from_pdf", &model_from_pdf, (py::arg("pdf"), py::arg("floatshift")=1<<11, py::arg("prob_bits")=14, py::arg("legacy")=false), "Builds a model from a probability density function, where pdf[i] is the probability of symbol i. Floatshift, prob_bits and legacy must match the coder.")
+        .staticmethod("from_pdf")
+        .def("from_counts", &model_from_counts, (py::arg("counts"), py::arg("prob_bits")=14, py::arg("legacy")=false), "Builds a model from integer counts, where counts[i] is the number of occurrences of symbol i. Prob_bits must match the coder. Legacy selects the rescaling of earlier versions.")
+        .staticmethod("from_counts")
+        .def("__len__", &rANSModel::size)
+        ;
+
+    py::class_<rANSAdaptiveModel>("rANSAdaptiveModel", "Order-0 model that learns the symbols while they are coded. Encoder and decoder must start from models built with the same parameters.", py::init<size_t, uint32_t, uint32_t, uint32_t, uint32_t>((py::arg("alphabet"), py::arg("prob_bits")=14, py::arg("increment")=24, py::arg("limit")=1<<16, py::arg("interval")=1024), "Starts from the uniform distribution. Every coded symbol adds increment to its count, the counts are halved when they sum to more than limit and the coding table is rebuilt every interval symbols. Prob_bits must match the coder."))
+        .def("reset", &rANSAdaptiveModel::reset, "Forgets everything learned, use before coding another stream.")
+        .def("__len__", &rANSAdaptiveModel::size)
+        ;
+
+    py::class_<rANSTansTable>("rANSTansTable", "Tables of the tANS backend, built from the quantized frequencies of a rANSModel.", py::init<const rANSModel&>((py::arg("model")), "Prob_bits of the model must be 5 to 16."))
+        .def("__len__", &rANSTansTable::size)
+        ;
+
+    py::class_<rANSParametricBank>("rANSParametricBank", "Quantized cdfs of a gaussian, laplace or logistic distribution for a discrete set of scales. Built once, it can be shared by any number of coders and threads.", py::no_init)
+        .def("from_scales", &bank_from_scales, (py::arg("family"), py::arg("scales"), py::arg("prob_bits")=14, py::arg("tail_mass")=RANS_PARAMETRIC_TAIL_MASS), "Builds one table per scale for family 'gaussian', 'laplace' or 'logistic'. Residuals falling outside a table with a probability below tail_mass are escaped. Prob_bits must match the coder.")
+        .staticmethod("from_scales")
+        .def("log_scales", &bank_log_scales, boost::python::args("min_scale","max_scale","count"), "Returns count scales spaced evenly in log space from min_scale to max_scale.")
+        .staticmethod("log_scales")
+        .def("scale_indices", &bank_scale_indices, boost::python::args("scales"), "Maps an array of scales to the indices of the largest scales of the bank not above them.")
+        .def("__len__", &rANSParametricBank::size)
+        ;
+
+    py::class_<pyrANSStreamWriter, boost::noncopyable>("rANSStreamWriter", "Encodes symbols with a rANSModel into a file as a stream of independent frames of window_size symbols. Memory stays bounded by the window, whatever the length of the stream.", py::init<std::string, const rANSModel&, size_t>((py::arg("path"), py::arg("model"), py::arg("window_size")=RANS_STREAM_WINDOW)))
+        .def("write", &pyrANSStreamWriter::write, boost::python::args("symbols"), "Appends an array of symbols to the stream.")
+        .def("close", &pyrANSStreamWriter::close, "Writes the remaining symbols and closes the file. Must be called, the stream is unreadable without its closing frame.")
+        .def("num_symbols", &pyrANSStreamWriter::num_symbols, "Returns the number of symbols written so far.")
+        ;
+
+    py::class_<pyrANSStreamReader, boost::noncopyable>("rANSStreamReader", "Decodes a file written by rANSStreamWriter frame by frame.", py::init<std::string, const rANSModel&>((py::arg("path"), py::arg("model")), "Model must be the one used to encode."))
+        .def("read", &pyrANSStreamReader::read, boost::python::args("n"), "Decodes up to n symbols and returns them as an uint32 array, shorter than n only at the end of the stream.")
+        .def("eof", &pyrANSStreamReader::eof, "Returns True once every symbol of the stream is decoded.")
+        ;
+
+    py::class_<pyrANSByte>("pyrANSByte", "rANS coder with a 32-bit state writing single bytes. Adds 4 bytes to every message instead of 8 and does not round to whole words, for many small messages.", py::init<uint32_t>((py::arg("prob_bits")=14), "Prob_bits can be at most 16."))
+        .def("encode_batch",&pyrANSByte::encode_batch, boost::python::args("symbols","pdfs"), "Encodes an array of N symbols with an (N, K) array of pdfs. Symbols are decoded in their original order.")
+        .def("encode_batch",&pyrANSByte::encode_batch_model, boost::python::args("symbols","model"), "Encodes an array of symbols with a precomputed rANSModel.")
+        .def("encode_batch_cdf",&pyrANSByte::encode_batch_cdf, boost::python::args("symbols","cdfs"), "Encodes an array of N symbols with an (N, K+1) array of integer cdfs.")
+        .def("decode_batch",&pyrANSByte::decode_batch, boost::python::args("pdfs"), "Decodes N symbols with an (N, K) array of pdfs and returns them as an uint32 array in original order.")
+        .def("decode_batch",&pyrANSByte::decode_batch_model, boost::python::args("model","n"), "Decodes n symbols with a precomputed rANSModel and returns them as an uint32 array in original order.")
+        .def("decode_batch_cdf",&pyrANSByte::decode_batch_cdf, boost::python::args("cdfs"), "Decodes N symbols with an (N, K+1) array of integer cdfs and returns them as an uint32 array in original order.")
+        .def("init_ec",&pyrANSByte::init_ec, "Drops anything encoded so far and starts a new message.")
+        .def("init_dc",&pyrANSByte::init_dc, boost::python::args("data"), "Initializes the decoder with a message from get_ec_buf or get_ec_bytes, as bytes or an uint8 array. Bytes and read-only arrays are decoded in place, a writeable array is copied first. Returns False if the message is too short or corrupt.")
+        .def("bytes_left",&pyrANSByte::bytes_left, "Number of bytes of the message not decoded yet, 0 once it is decoded exactly.")
+        .def("decode_failed",&pyrANSByte::decode_failed, "True if the message was rejected or ended before all symbols asked for were decoded, since the last init_dc.")
+        .def("get_ec_buf",&pyrANSByte::get_ec_buf, "Flushes the coder state and returns the message as a read-only uint8 array. The coder is ready for the next message.")
+        .def("get_ec_bytes",&pyrANSByte::get_ec_bytes, "Flushes the coder state and returns the message as bytes. The coder is ready for the next message.")
+        ;
+
     py::class_<pyrANS>("pyrANS")
         .def(py::init<uint32_t, uint32_t>())
         .def("encode_sym",&pyrANS::encode_sym, boost::python::args("symbol","pdf"), "Encodes a symbol, which is an uint32_t value. Symbol is the symbol to encode, pdf is the corresponding probability density function, where pdf[i] is the probability of symbol i. pdf.size() has to be equal to the alphabet size.")
+        .def("encode_batch",&pyrANS::encode_batch, boost::python::args("symbols","pdfs"), "Encodes an array of N symbols in one call. Pdfs is an (N, K) array where pdfs[i] is the probability density function used for symbols[i]. Symbols are decoded in their original order.")
+        .def("encode_sym",&pyrANS::encode_sym_model, boost::python::args("symbol","model"), "Encodes a symbol with a precomputed rANSModel instead of a pdf.")
+        .def("encode_batch",&pyrANS::encode_batch_model, boost::python::args("symbols","model"), "Encodes an array of N symbols with a precomputed rANSModel. Symbols are decoded in their original order.")
         .def("decode_sym",&pyrANS::decode_sym,  boost::python::args("pdf"), "Decodes and advances the coder to the next symbol. Pdf is the probability density function, where pdf[i] is the probability of symbol i. pdf.size() has to be equal to the alphabet size.")
+        .def("decode_batch",&pyrANS::decode_batch, boost::python::args("pdfs"), "Decodes N symbols in one call and returns them as an uint32 array, in the order they were passed to encode_batch. Pdfs is an (N, K) array where pdfs[i] is the probability density function of the i-th symbol.")
+        .def("decode_sym",&pyrANS::decode_sym_model, boost::python::args("model"), "Decodes a symbol with a precomputed rANSModel instead of a pdf.")
+        .def("decode_batch",&pyrANS::decode_batch_model, boost::python::args("model","n"), "Decodes n symbols with a precomputed rANSModel and returns them as an uint32 array in original order.")
+        .def("encode_batch",&pyrANS::encode_batch_adaptive, boost::python::args("symbols","model"), "Encodes an array of N symbols with a rANSAdaptiveModel, which learns them. Symbols are decoded in their original order.")
+        .def("decode_sym",&pyrANS::decode_sym_adaptive, boost::python::args("model"), "Decodes a symbol with a rANSAdaptiveModel, which learns it.")
+        .def("decode_batch",&pyrANS::decode_batch_adaptive, boost::python::args("model","n"), "Decodes n symbols with a rANSAdaptiveModel and returns them as an uint32 array in original order.")
+        .def("encode_sym_cdf",&pyrANS::encode_sym_cdf, boost::python::args("symbol","cdf"), "Encodes a symbol with an integer cdf of K+1 entries, starting with 0 and ending with 1 << prob_bits, as uint32 or int32. No float conversion or quantization takes place.")
+        .def("encode_batch_cdf",&pyrANS::encode_batch_cdf, boost::python::args("symbols","cdfs"), "Encodes an array of N symbols with an (N, K+1) array of integer cdfs, where cdfs[i] belongs to symbols[i]. Symbols are decoded in their original order.")
+        .def("decode_sym_cdf",&pyrANS::decode_sym_cdf, boost::python::args("cdf"), "Decodes a symbol with an integer cdf of K+1 entries.")
+        .def("decode_batch_cdf",&pyrANS::decode_batch_cdf, boost::python::args("cdfs"), "Decodes N symbols with an (N, K+1) array of integer cdfs and returns them as an uint32 array in original order.")
+        .def("encode_batch_parametric",&pyrANS::encode_batch_parametric, boost::python::args("symbols","means","scale_indices","bank"), "Encodes an array of N int32 symbols with a rANSParametricBank. Symbols[i] is coded relative to round(means[i]) with the table of scale_indices[i]. Symbols are decoded in their original order.")
+        .def("decode_batch_parametric",&pyrANS::decode_batch_parametric, boost::python::args("means","scale_indices","bank"), "Decodes N symbols with a rANSParametricBank and returns them as an int32 array in original order. Means and scale_indices must be the ones used to encode.")
+        .def("encode_interleaved",&pyrANS::encode_interleaved, (py::arg("symbols"), py::arg("model"), py::arg("ways")=4), "Encodes an array of symbols with a precomputed rANSModel using 1, 2, 4 or 8 interleaved states and returns a self-contained stream. Does not touch the coder's own buffer.")
+        .def("decode_interleaved",&pyrANS::decode_interleaved, boost::python::args("data","model","n"), "Decodes n symbols from a stream returned by encode_interleaved or encode_wide, in original order.")
+        .def("encode_wide",&pyrANS::encode_wide, (py::arg("symbols"), py::arg("model"), py::arg("lanes")=8), "Encodes an array of symbols with a precomputed rANSModel for the vectorized decoder, using 8 (AVX2) or 16 (AVX-512) lanes. Decode with decode_interleaved.")
+        .def("encode_blocks",&pyrANS::encode_blocks, (py::arg("symbols"), py::arg("pdfs"), py::arg("block_size")=1<<16), "Encodes an array of N symbols as independent blocks of block_size symbols on a thread pool and returns the container. Pdfs is an (N, K) array.")
+        .def("encode_blocks",&pyrANS::encode_blocks_model, (py::arg("symbols"), py::arg("model"), py::arg("block_size")=1<<16), "Encodes an array of symbols with a precomputed rANSModel as independent blocks on a thread pool and returns the container.")
+        .def("decode_blocks",&pyrANS::decode_blocks, boost::python::args("data","pdfs"), "Decodes a container returned by encode_blocks on a thread pool. Pdfs is an (N, K) array.")
+        .def("decode_blocks",&pyrANS::decode_blocks_model, boost::python::args("data","model"), "Decodes a container returned by encode_blocks with a precomputed rANSModel on a thread pool.")
+        .def("decode_range",&pyrANS::decode_range, boost::python::args("data","pdfs","begin","end"), "Decodes the symbols [begin, end) of a container returned by encode_blocks, decoding only the blocks that overlap the range. Pdfs is the (N, K) array of the whole container.")
+        .def("decode_range",&pyrANS::decode_range_model, boost::python::args("data","model","begin","end"), "Decodes the symbols [begin, end) of a container returned by encode_blocks with a precomputed rANSModel, decoding only the blocks that overlap the range.")
+        .def("encode_tans",&pyrANS::encode_tans, boost::python::args("symbols","table"), "Encodes an array of symbols with the tANS backend and returns a self-contained stream. Decoding needs a table lookup and a bit read per symbol instead of a multiplication. Does not touch the coder's own buffer.")
+        .def("decode_tans",&pyrANS::decode_tans, boost::python::args("data","table","n"), "Decodes n symbols from a stream returned by encode_tans, in original order.")
+        .def("encode_context",&pyrANS::encode_context, (py::arg("symbols"), py::arg("alphabet"), py::arg("order")=1, py::arg("adaptive")=false), "Encodes an array of symbols with an order-1 or order-2 context model, coding every symbol with the distribution that follows the previous one or two symbols. A static model is stored in the stream, an adaptive one learns while coding. Returns a self-contained stream and does not touch the coder's own buffer.")
+        .def("decode_context",&pyrANS::decode_context, boost::python::args("data"), "Decodes a stream returned by encode_context and returns the symbols as an uint32 array in original order.")
+        .def("encode_static",&pyrANS::encode_static, boost::python::args("symbols","alphabet"), "Encodes an array of symbols with a static model built from their counts and returns a self-describing stream, holding the symbol count, prob_bits and the compressed frequency table. Does not touch the coder's own buffer.")
+        .def("encode_static",&pyrANS::encode_static_model, boost::python::args("symbols","model"), "Encodes an array of symbols with a precomputed rANSModel and returns a self-describing stream holding the model.")
+        .def("decode_static",&pyrANS::decode_static, boost::python::args("data"), "Decodes a stream returned by encode_static and returns the symbols as an uint32 array in original order. Nothing but the stream is needed.")
+        .def("set_legacy_quantization",&pyrANS::set_legacy_quantization, boost::python::args("legacy"), "Selects the quantization of pdfs. True, the default, scales by floatshift like earlier versions, so that their text still decodes. False quantizes in full precision and never gives a symbol a frequency of 0. Encoder and decoder must use the same setting.")
+        .def("set_num_threads",&pyrANS::set_num_threads, boost::python::args("threads"), "Sets the number of threads used by encode_blocks and decode_blocks. 0 means one per core.")
+        .def("stats",&pyrANS::stats, "Returns a dict of counters over everything coded through the coder's own buffer: symbols, renormalization words, ideal_bits under the given pdfs, model_bits under the quantized frequencies, symbols clamped to the smallest frequency, and cycles spent quantizing and coding. All 0 with enabled False unless built with -DRANS_STATS=ON.")
+        .def("reset_stats",&pyrANS::reset_stats, "Sets all counters returned by stats to 0.")
 
         .def("init_ec",&pyrANS::init_ec, "Initializes encoder. This is usually not necessary since the Coder should always be in a valid state.")
-        .def("init_dc",&pyrANS::init_dc, boost::python::args("data"), "Initializes the decoder with the buffer obtained by calling get_ec_buf.")
-        .def("get_ec_buf",&pyrANS::get_ec_buf, "Flushes the coder state into the buffer and returns the buffer. Coder is reset after calling this function.")
+        .def("init_dc",&pyrANS::init_dc, boost::python::args("data"), "Initializes the decoder with the buffer obtained by calling get_ec_buf. A read-only contiguous uint32 buffer, like the one get_ec_buf returns, is decoded in place, a writeable one is copied first.")
+        .def("init_dc_mmap",&pyrANS::init_dc_mmap, boost::python::args("path"), "Initializes the decoder with a file holding the buffer obtained by calling get_ec_buf, e.g. saved with tofile. The file is memory mapped and decoded in place, only the pages the decoder touches are read. It must not be modified while decoding.")
+        .def("get_ec_buf",&pyrANS::get_ec_buf, "Flushes the coder state into the buffer and returns the buffer, as a read-only array. Coder is reset after calling this function.")
         ; 
 
 }
@@ -0,0 +1,39 @@
+//
+// Adaptive order-0 frequency model for the rANSCoder.
+//
+
+#include "rANSAdaptiveModel.h"
+#include <algorithm>
+
+rANSAdaptiveModel::rANSAdaptiveModel(size_t alphabet, uint32_t prob_bits, uint32_t increment, uint32_t limit,
+                                     uint32_t interval)
+    : prob_bits(prob_bits), increment(increment), limit(limit), interval(std::max(interval, 1u)),
+      counts(alphabet), freqs(alphabet), cdf(alphabet+1) {
+
+    reset();
+}
+
+void rANSAdaptiveModel::reset() {
+    std::fill(counts.begin(), counts.end(), 1);
+    total = counts.size();
+
+    next_interval = std::min<uint32_t>(RANS_ADAPTIVE_FIRST_INTERVAL, interval);
+    until_rebuild = next_interval;
+    rANSQuantizeCounts(counts.data(), counts.size(), prob_bits, freqs.data(), cdf.data());
+}
+
+void rANSAdaptiveModel::rescale() {
+    total = 0;
+    for (size_t i = 0; i<counts.size(); i++) {
+        // counts never drop to 0, so every symbol keeps some probability
+        counts[i] = (counts[i] + 1) / 2;
+        total += counts[i];
+    }
+}
+
+void rANSAdaptiveModel::rebuild() {
+    rANSQuantizeCounts(counts.data(), counts.size(), prob_bits, freqs.data(), cdf.data());
+
+    next_interval = std::min(next_interval * 2, interval);
+    until_rebuild = next_interval;
+}
@@ -0,0 +1,110 @@
+//
+// Adaptive order-0 frequency model for the rANSCoder.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSADAPTIVEMODEL_H
+#define CLIONSCRATCHPAD_RANSADAPTIVEMODEL_H
+
+#include "rANSSearch.h"
+#include "rANSQuantize.h"
+#include <vector>
+#include <cstddef>
+
+// Number of symbols after which a fresh model rebuilds its coding table for the first time. The interval then doubles
+// up to the configured one, so the model adapts quickly at the start of a stream.
+#define RANS_ADAPTIVE_FIRST_INTERVAL 16
+
+/**
+ * @brief A frequency model that learns the distribution of the symbols while they are coded.
+ *
+ * @details Every coded symbol adds increment to its count. When the counts sum to more than limit they are halved,
+ * which bounds the memory of the model and lets it follow a drifting distribution.
+ *
+ * rANS needs frequencies summing to a power of two, which raw counts do not. The model therefore codes with a table
+ * quantized from the counts by rANSQuantizeCounts and rebuilds that table every interval symbols, instead of
+ * keeping a cumulative count tree up to date after every symbol. An update is then a single add, and a symbol is
+ * coded with a table lookup and a search over the cdf.
+ *
+ * Encoder and decoder apply the same integer updates at the same positions, so they stay in sync on every machine.
+ * Since rANS decodes in reverse, the coder encodes a whole batch at once: it runs the model forwards over the symbols,
+ * then encodes them backwards.
+ *
+ * Example usage:
+ *
+ *     rANSAdaptiveModel enc_model(256);
+ *     rANSCoder encoder;
+ *     encoder.encode_batch(syms, n, enc_model);
+ *     auto encoded = encoder.get_buffer();
+ *
+ *     rANSAdaptiveModel dec_model(256);
+ *     rANSCoder decoder;
+ *     decoder.init_dc(encoded);
+ *     decoder.decode_batch(dec_model, n, out);
+ *
+ * @attention Encoder and decoder must start from models built with the same parameters, and a model keeps learning,
+ * so use a fresh or reset model for every stream.
+ */
+class rANSAdaptiveModel {
+
+private:
+
+    uint32_t prob_bits;
+    uint32_t increment;
+    uint32_t limit;
+    uint32_t interval;
+    std::vector<uint32_t> counts;
+    uint64_t total;
+    std::vector<uint32_t> freqs;
+    std::vector<uint32_t> cdf;
+    uint32_t next_interval;
+    uint32_t until_rebuild;
+
+    void rescale();
+    void rebuild();
+
+public:
+
+    /**
+     * @brief Builds a model starting from the uniform distribution.
+     *
+     * @param[in] alphabet Size of the alphabet, at most 2 to the power of prob_bits.
+     * @param[in] prob_bits The number of bits used to describe probabilities. Must match the coder.
+     * @param[in] increment Amount added to the count of a symbol after it is coded.
+     * @param[in] limit The counts are halved when their sum exceeds this.
+     * @param[in] interval Number of symbols between rebuilds of the coding table.
+     */
+    rANSAdaptiveModel(size_t alphabet, uint32_t prob_bits = 14, uint32_t increment = 24, uint32_t limit = 1 << 16,
+                      uint32_t interval = 1024);
+
+    /**
+     * @brief Forgets everything learned and starts over from the uniform distribution.
+     */
+    void reset();
+
+    uint32_t get_prob_bits() const { return prob_bits; }
+    size_t size() const { return counts.size(); }
+    const uint32_t* get_freqs() const { return freqs.data(); }
+    const uint32_t* get_cdf() const { return cdf.data(); }
+
+    /**
+     * @brief Returns the symbol whose bucket of the current table contains the cumulative frequency cum_prob.
+     */
+    uint32_t find_symbol(uint32_t cum_prob) const {
+        return rANSFindSymbol(cdf.data(), counts.size(), cum_prob);
+    }
+
+    /**
+     * @brief Learns a coded symbol.
+     *
+     * @details Must be called after every symbol, in the order of decoding. The rANSCoder does this itself.
+     */
+    void update(uint32_t sym) {
+        counts[sym] += increment;
+        total += increment;
+        if (total > limit) rescale();
+        if (--until_rebuild == 0) rebuild();
+    }
+
+};
+
+#endif //CLIONSCRATCHPAD_RANSADAPTIVEMODEL_H
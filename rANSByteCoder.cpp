@@ -0,0 +1,233 @@
+//
+// Byte-oriented rANS coder with a 32-bit state for small messages.
+//
+
+#include "rANSByteCoder.h"
+#include <algorithm>
+#include <iostream>
+
+// Number of symbols encoded between checks of the buffer size. Every symbol writes at most 2 bytes.
+#define RANS_BYTE_CHUNK (1 << 12)
+
+rANSByteCoder::rANSByteCoder(uint32_t prob_bits) : PROB_BITS(prob_bits) {
+    if (PROB_BITS > RANS_BYTE_MAX_BITS) {
+        std::cout << "ERROR: The byte coder supports at most " << RANS_BYTE_MAX_BITS << " prob_bits." << std::endl;
+        PROB_BITS = RANS_BYTE_MAX_BITS;
+    }
+    PROB_SCALE = 1u << PROB_BITS;
+    init_ec();
+}
+
+void rANSByteCoder::init_ec() {
+    RansEncInit(&state);
+    vec.clear();
+    flushed = false;
+    dc_begin = nullptr;
+    dc_ptr = nullptr;
+    dc_error = false;
+}
+
+bool rANSByteCoder::check_model(const rANSModel& model) const {
+    if (model.get_prob_bits() != PROB_BITS) {
+        std::cout << "ERROR: Model prob_bits (" << model.get_prob_bits() << ") do not match coder prob_bits ("
+                  << PROB_BITS << ")." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool check_cdfs(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet, uint32_t scale) {
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t* cdf = cdfs + i*(alphabet+1);
+        if (cdf[alphabet] != scale) {
+            std::cout << "ERROR: Cdf " << i << " sums to " << cdf[alphabet] << " instead of " << scale << "."
+                      << std::endl;
+            return false;
+        }
+        if (syms && (syms[i] >= alphabet || cdf[syms[i]+1] <= cdf[syms[i]])) {
+            std::cout << "ERROR: Symbol " << i << " has a frequency of 0 in its cdf." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t* rANSByteCoder::ec_open(size_t room) {
+    size_t pos = vec.size();
+    if (vec.capacity() < pos + room) {
+        vec.reserve(std::max(pos + room, vec.capacity() + vec.capacity() / 2));
+    }
+
+    vec.resize(pos + room);
+    return vec.data() + pos;
+}
+
+void rANSByteCoder::ec_close(uint8_t* ptr) {
+    vec.resize(ptr - vec.data());
+}
+
+void rANSByteCoder::encode_batch(const uint32_t* syms, size_t n, const rANSModel& model) {
+    if (!check_model(model)) return;
+
+    const uint32_t* cdf = model.get_cdf();
+    const uint32_t* freqs = model.get_freqs();
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= model.size() || freqs[syms[i]] == 0) {
+            std::cout << "ERROR: Symbol " << i << " has a frequency of 0 in the model." << std::endl;
+            return;
+        }
+    }
+
+    // rANS works like a stack, so encode backwards to decode in the original order
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_BYTE_CHUNK ? i - RANS_BYTE_CHUNK : 0;
+        uint8_t* ptr = ec_open(2 * (i - stop));
+        for (; i > stop; i--) {
+            uint32_t sym = syms[i-1];
+            RansEncPutFwd(&state, &ptr, cdf[sym], freqs[sym], PROB_BITS);
+        }
+        ec_close(ptr);
+    }
+}
+
+void rANSByteCoder::encode_batch(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet) {
+    std::vector<uint32_t> freqs(alphabet);
+    std::vector<uint32_t> cdf(alphabet+1);
+
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= alphabet) {
+            std::cout << "ERROR: Symbol " << i << " is outside of the alphabet." << std::endl;
+            return;
+        }
+    }
+
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_BYTE_CHUNK ? i - RANS_BYTE_CHUNK : 0;
+        uint8_t* ptr = ec_open(2 * (i - stop));
+        for (; i > stop; i--) {
+            rANSQuantizePdf(pdfs + (i-1)*alphabet, alphabet, PROB_BITS, freqs.data(), cdf.data());
+            uint32_t sym = syms[i-1];
+            RansEncPutFwd(&state, &ptr, cdf[sym], freqs[sym], PROB_BITS);
+        }
+        ec_close(ptr);
+    }
+}
+
+void rANSByteCoder::encode_batch_cdf(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet) {
+    if (!check_cdfs(syms, cdfs, n, alphabet, PROB_SCALE)) return;
+
+    const size_t stride = alphabet+1;
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_BYTE_CHUNK ? i - RANS_BYTE_CHUNK : 0;
+        uint8_t* ptr = ec_open(2 * (i - stop));
+        for (; i > stop; i--) {
+            const uint32_t* cdf = cdfs + (i-1)*stride;
+            uint32_t sym = syms[i-1];
+            RansEncPutFwd(&state, &ptr, cdf[sym], cdf[sym+1] - cdf[sym], PROB_BITS);
+        }
+        ec_close(ptr);
+    }
+}
+
+std::vector<uint8_t> rANSByteCoder::release_buffer() {
+    // a message that did not move the coder from its initial state is empty, the decoder starts from that state
+    if (!flushed && !(vec.empty() && state == RANS_BYTE_L)) {
+        uint8_t* ptr = ec_open(4);
+        RansEncFlushFwd(&state, &ptr);
+    }
+    RansEncInit(&state);
+    flushed = false;
+
+    std::vector<uint8_t> out;
+    out.swap(vec);
+    return out;
+}
+
+bool rANSByteCoder::init_dc_view(const uint8_t* data, size_t size) {
+    flushed = true;
+    dc_error = false;
+    if (size == 0) {
+        dc_begin = dc_ptr = data;
+        state = RANS_BYTE_L;
+        return true;
+    }
+    if (size < 4) {
+        std::cout << "ERROR: Encoded buffer is too small." << std::endl;
+        dc_begin = dc_ptr = nullptr;
+        state = RANS_BYTE_L;
+        dc_error = true;
+        return false;
+    }
+
+    dc_begin = data;
+    dc_ptr = data + size;
+    RansDecInitRev(&state, &dc_ptr);
+
+    if (state < RANS_BYTE_L) {
+        // not a flushed state, decoding from it would never renormalize
+        std::cout << "ERROR: Encoded buffer is corrupt." << std::endl;
+        dc_begin = dc_ptr = nullptr;
+        state = RANS_BYTE_L;
+        dc_error = true;
+        return false;
+    }
+    return true;
+}
+
+// Reports a decode that ran out of bytes, and zeroes the n symbols it could not decode.
+static void decode_exhausted(uint32_t* out, size_t n, bool& error) {
+    std::cout << "ERROR: Encoded buffer ended before all symbols were decoded." << std::endl;
+    std::fill(out, out + n, 0);
+    error = true;
+}
+
+void rANSByteCoder::decode_batch(const rANSModel& model, size_t n, uint32_t* out) {
+    if (!check_model(model)) return;
+
+    const uint32_t* cdf = model.get_cdf();
+    const uint32_t* freqs = model.get_freqs();
+    const uint8_t* ptr = dc_ptr;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t sym = model.find_symbol(RansDecGet(&state, PROB_BITS));
+        if (!RansDecAdvanceRev(&state, &ptr, dc_begin, cdf[sym], freqs[sym], PROB_BITS)) {
+            decode_exhausted(out + i, n - i, dc_error);
+            break;
+        }
+        out[i] = sym;
+    }
+    dc_ptr = ptr;
+}
+
+void rANSByteCoder::decode_batch(const float* pdfs, size_t n, size_t alphabet, uint32_t* out) {
+    std::vector<uint32_t> freqs(alphabet);
+    std::vector<uint32_t> cdf(alphabet+1);
+
+    const uint8_t* ptr = dc_ptr;
+    for (size_t i = 0; i < n; i++) {
+        rANSQuantizePdf(pdfs + i*alphabet, alphabet, PROB_BITS, freqs.data(), cdf.data());
+        uint32_t sym = rANSFindSymbol(cdf.data(), alphabet, RansDecGet(&state, PROB_BITS));
+        if (!RansDecAdvanceRev(&state, &ptr, dc_begin, cdf[sym], freqs[sym], PROB_BITS)) {
+            decode_exhausted(out + i, n - i, dc_error);
+            break;
+        }
+        out[i] = sym;
+    }
+    dc_ptr = ptr;
+}
+
+void rANSByteCoder::decode_batch_cdf(const uint32_t* cdfs, size_t n, size_t alphabet, uint32_t* out) {
+    if (!check_cdfs(nullptr, cdfs, n, alphabet, PROB_SCALE)) return;
+
+    const size_t stride = alphabet+1;
+    const uint8_t* ptr = dc_ptr;
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t* cdf = cdfs + i*stride;
+        uint32_t sym = rANSFindSymbol(cdf, alphabet, RansDecGet(&state, PROB_BITS));
+        if (!RansDecAdvanceRev(&state, &ptr, dc_begin, cdf[sym], cdf[sym+1] - cdf[sym], PROB_BITS)) {
+            decode_exhausted(out + i, n - i, dc_error);
+            break;
+        }
+        out[i] = sym;
+    }
+    dc_ptr = ptr;
+}
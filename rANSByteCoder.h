@@ -0,0 +1,151 @@
+//
+// Byte-oriented rANS coder with a 32-bit state for small messages.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSBYTECODER_H
+#define CLIONSCRATCHPAD_RANSBYTECODER_H
+
+#include "rans_byte_custom.hpp"
+#include "rANSModel.h"
+#include "rANSSearch.h"
+#include "rANSQuantize.h"
+#include <vector>
+#include <cstddef>
+
+// Largest prob_bits of the byte coder. The 32-bit state keeps 23 bits below the renormalization bound, so at 16 bits
+// a symbol still writes at most 2 bytes.
+#define RANS_BYTE_MAX_BITS 16
+
+/**
+ * @brief A rANS coder with a 32-bit state that renormalizes byte by byte and produces a byte stream.
+ *
+ * @details The rANSCoder writes 32-bit words and flushes a 64-bit state, so every message costs at least 8 bytes on
+ * top of its payload and is rounded up to whole words. This coder flushes a 4-byte state and writes single bytes,
+ * which makes a big difference for messages of a few symbols. A message that leaves the coder in its initial state,
+ * like an empty one, takes no bytes at all. For long texts the rANSCoder is faster and a little more precise.
+ *
+ * The interface follows the batch methods of the rANSCoder: the encoder appends, the buffer is handed out with
+ * release_buffer, and the decoder reads it backwards from a view, returning the symbols in original order.
+ *
+ * Example usage:
+ *
+ *     rANSByteCoder encoder;
+ *     encoder.encode_batch(syms, n, model);
+ *     std::vector<uint8_t> message = encoder.release_buffer();
+ *
+ *     rANSByteCoder decoder;
+ *     decoder.init_dc_view(message.data(), message.size());
+ *     decoder.decode_batch(model, n, out);
+ */
+class rANSByteCoder {
+
+private:
+
+    RansState state;
+    uint32_t PROB_BITS;
+    uint32_t PROB_SCALE;
+    std::vector<uint8_t> vec;
+    bool flushed = false;
+    const uint8_t* dc_begin = nullptr;
+    const uint8_t* dc_ptr = nullptr;
+    bool dc_error = false;
+
+    bool check_model(const rANSModel& model) const;
+    uint8_t* ec_open(size_t room);
+    void ec_close(uint8_t* ptr);
+
+public:
+
+    /**
+     * @brief Creates a coder ready to encode.
+     *
+     * @param[in] prob_bits The number of bits used to describe probabilities, at most RANS_BYTE_MAX_BITS.
+     */
+    explicit rANSByteCoder(uint32_t prob_bits = 14);
+
+    /**
+     * @brief Starts the coder as an encoder, dropping anything encoded so far.
+     */
+    void init_ec();
+
+    /**
+     * @brief Encodes a whole array of symbols with a precomputed model.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in] model Model to encode with. Must use the same prob_bits as the coder.
+     */
+    void encode_batch(const uint32_t* syms, size_t n, const rANSModel& model);
+
+    /**
+     * @brief Encodes a whole array of symbols with one probability distribution per symbol.
+     *
+     * @details The distributions are quantized with rANSQuantizePdf.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] pdfs Array of n*alphabet probabilities, where pdfs[i*alphabet+j] is the probability of symbol j at
+     * position i.
+     * @param[in] n Number of symbols.
+     * @param[in] alphabet Size of the alphabet.
+     */
+    void encode_batch(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet);
+
+    /**
+     * @brief Encodes a whole array of symbols with one integer cdf per symbol, see rANSCoder::encode_batch_cdf.
+     */
+    void encode_batch_cdf(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet);
+
+    /**
+     * @brief Flushes the state and hands out the encoded bytes. The coder is ready to encode the next message.
+     */
+    std::vector<uint8_t> release_buffer();
+
+    /**
+     * @brief Starts decoding a message in place, without copying it.
+     *
+     * @param[in] data The bytes returned by release_buffer. Must stay valid and unchanged while decoding.
+     * @param[in] size Number of bytes.
+     * @return false if the message is too short to hold a state or its state is corrupt. The decoder is then left
+     * with an empty message, every read from which fails.
+     */
+    bool init_dc_view(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Returns the number of bytes of the message not read yet. 0 once a message is decoded exactly.
+     */
+    size_t bytes_left() const { return dc_ptr - dc_begin; }
+
+    /**
+     * @brief Returns true if the message was rejected or ended before all symbols asked for were decoded, since the
+     * last init_dc_view. The symbols that could not be decoded are returned as 0.
+     */
+    bool decode_failed() const { return dc_error; }
+
+    /**
+     * @brief Decodes a whole array of symbols with a precomputed model.
+     *
+     * @details The decoder never reads before the message. If it ends before n symbols are decoded, the rest are
+     * returned as 0 and decode_failed turns true. A message decoded exactly leaves bytes_left at 0, so bytes left over
+     * after the last call point to a wrong model or symbol count.
+     *
+     * @param[in] model Model to decode with - must correspond exactly to the distribution used to encode.
+     * @param[in] n Number of symbols to decode.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+     */
+    void decode_batch(const rANSModel& model, size_t n, uint32_t* out);
+
+    /**
+     * @brief Decodes a whole array of symbols with one probability distribution per symbol.
+     */
+    void decode_batch(const float* pdfs, size_t n, size_t alphabet, uint32_t* out);
+
+    /**
+     * @brief Decodes a whole array of symbols with one integer cdf per symbol.
+     */
+    void decode_batch_cdf(const uint32_t* cdfs, size_t n, size_t alphabet, uint32_t* out);
+
+    uint32_t get_prob_bits() const { return PROB_BITS; }
+
+};
+
+#endif //CLIONSCRATCHPAD_RANSBYTECODER_H
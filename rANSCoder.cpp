@@ -3,7 +3,107 @@
 //
 
 #include "rANSCoder.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <memory>
+
+// Number of symbols the batch encoders write between checks of the buffer size. Every symbol writes at most one word,
+// so the buffer is reserved with this much slack on top of the estimated output.
+#define RANS_EC_CHUNK (1 << 12)
+
+// Estimates the encoded size of symbols with per-symbol distributions, costing each symbol at its probability scaled
+// to a frequency, like rANSModel::estimate_words.
+static size_t estimate_words(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet, uint32_t prob_bits) {
+    const float scale = (float) ((uint64_t) 1 << prob_bits);
+
+    uint64_t bits = 0;
+    for (size_t i = 0; i<n; i++) {
+        float f = pdfs[i*alphabet + syms[i]] * scale;
+        uint32_t freq = f > 1.0f ? (f < scale ? (uint32_t) f : (uint32_t) ((uint64_t) 1 << prob_bits)) : 1;
+        bits += rANSSymbolCost(freq, prob_bits);
+    }
+
+    return rANSCostWords(bits);
+}
+
+// Estimates the encoded size of symbols with integer cdfs.
+static size_t estimate_words(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet, uint32_t prob_bits) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i<n; i++) {
+        const uint32_t* cdf = cdfs + i*(alphabet+1);
+        bits += rANSSymbolCost(cdf[syms[i]+1] - cdf[syms[i]], prob_bits);
+    }
+
+    return rANSCostWords(bits);
+}
+
+// The batch loops over a model or a matrix of cdfs. They encode syms[n-1] down to syms[0], writing forwards at *pptr,
+// and decode from a cursor reading backwards, like the coder's own buffer. The decoders stop before reading a word
+// below begin and return the number of symbols they decoded.
+static void encode_model_run(Rans64State* r, uint32_t** pptr, const uint32_t* syms, size_t n, const rANSModel& model) {
+    const uint32_t bits = model.get_prob_bits();
+    const Rans64EncSymbol* enc_syms = model.get_enc_symbols();
+    for (size_t i = n; i > 0; i--) {
+        Rans64EncPutSymbolFwd(r, pptr, enc_syms + syms[i-1], bits);
+    }
+}
+
+static size_t decode_model_run(Rans64State* r, const uint32_t** pptr, const uint32_t* begin, const rANSModel& model,
+                               size_t n, uint32_t* out) {
+    const uint32_t bits = model.get_prob_bits();
+    const rANSDecSlot* slots = model.get_slots();
+    if (slots) {
+        for (size_t i = 0; i < n; i++) {
+            const rANSDecSlot& slot = slots[Rans64DecGet(r, bits)];
+            if (!Rans64DecAdvanceRevBounded(r, pptr, begin, slot.start, slot.freq, bits)) return i;
+            out[i] = slot.sym;
+        }
+        return n;
+    }
+
+    const uint32_t* cdf = model.get_cdf();
+    const uint32_t* freqs = model.get_freqs();
+    for (size_t i = 0; i < n; i++) {
+        uint32_t sym = model.find_symbol(Rans64DecGet(r, bits));
+        if (!Rans64DecAdvanceRevBounded(r, pptr, begin, cdf[sym], freqs[sym], bits)) return i;
+        out[i] = sym;
+    }
+    return n;
+}
+
+static void encode_cdf_run(Rans64State* r, uint32_t** pptr, const uint32_t* syms, const uint32_t* cdfs, size_t n,
+                           size_t alphabet, uint32_t bits) {
+    const size_t stride = alphabet + 1;
+    for (size_t i = n; i > 0; i--) {
+        const uint32_t* cdf = cdfs + (i-1)*stride;
+        uint32_t sym = syms[i-1];
+        Rans64EncPutFwd(r, pptr, cdf[sym], cdf[sym+1] - cdf[sym], bits);
+    }
+}
+
+static size_t decode_cdf_run(Rans64State* r, const uint32_t** pptr, const uint32_t* begin, const uint32_t* cdfs,
+                             size_t n, size_t alphabet, uint32_t bits, uint32_t* out) {
+    const size_t stride = alphabet + 1;
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t* cdf = cdfs + i*stride;
+        uint32_t sym = rANSFindSymbol(cdf, alphabet, Rans64DecGet(r, bits));
+        if (!Rans64DecAdvanceRevBounded(r, pptr, begin, cdf[sym], cdf[sym+1] - cdf[sym], bits)) return i;
+        out[i] = sym;
+    }
+    return n;
+}
+
+// Reports a decode of the coder's own buffer that ran out of words, and zeroes the n symbols it could not decode.
+template<typename T>
+static void decode_exhausted(T* out, size_t n, bool& error) {
+    std::cout << "ERROR: Encoded buffer ended before all symbols were decoded." << std::endl;
+    std::fill(out, out + n, 0);
+    error = true;
+}
 
 rANSCoder::rANSCoder() {
     Rans64EncInit(&(this->state));
@@ -19,35 +119,166 @@ rANSCoder::rANSCoder(uint32_t floatshift, uint32_t prob_bits) {
     flushed = true;
 }
 
-void rANSCoder::convert_pdf(std::vector<float> orpdf, std::vector<uint32_t>& npdf, std::vector<uint32_t>& cdf){
+void rANSCoder::convert_pdf(const float* orpdf, size_t size, uint32_t* npdf, uint32_t* cdf) const {
 
-    for (int i = 0; i<orpdf.size(); i++) {
+    if (!LEGACY_QUANTIZATION) {
+        rANSQuantizePdf(orpdf, size, PROB_BITS, npdf, cdf);
+        return;
+    }
+
+    for (size_t i = 0; i<size; i++) {
         npdf[i] = orpdf[i]*FLOATSHIFT;
+    }
 
-        if (npdf[i] < MIN_PROBABILITY) {
-            npdf[i] = MIN_PROBABILITY;
-        }
+    rANSModel::quantize(npdf, size, PROB_BITS, MIN_PROBABILITY, npdf, cdf);
+}
+
+void rANSCoder::quantize_pdf(const float* orpdf, size_t size, uint32_t* npdf, uint32_t* cdf) {
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock();)
+    convert_pdf(orpdf, size, npdf, cdf);
+
+    // the total the ideal cost is normalized with, clamped like the quantization does, once per pdf
+    RANS_STATS_ONLY(pdf_total = 0;)
+    RANS_STATS_ONLY(for (size_t i = 0; i < size; i++) pdf_total += orpdf[i] > 0.0f ? std::min(orpdf[i], 1.0f) : 0.0f;)
+    RANS_STATS_ONLY(counters.quantize_cycles += rANSStatsClock() - start;)
+}
+
+#ifdef RANS_STATS
+void rANSCoder::count_call(uint64_t start, size_t words, size_t n) {
+    counters.coding_cycles += rANSStatsClock() - start;
+    counters.words += words;
+    counters.symbols += n;
+}
+
+void rANSCoder::count_symbol(uint32_t freq) {
+    // the coder is given the quantized distribution, there is no loss to tell apart
+    double bits = PROB_BITS - std::log2((double) freq);
+    counters.ideal_bits += bits;
+    counters.model_bits += bits;
+}
+
+// Called from within the coding loops right after quantize_pdf, whose total of pdf it uses. It takes its own time out
+// of the coding time.
+void rANSCoder::count_symbol(const float* pdf, uint32_t sym, uint32_t freq) {
+    const uint64_t start = rANSStatsClock();
+
+    // probabilities are clamped to [0, 1] and normalized like the quantization does
+    const double total = pdf_total;
+    double p = pdf[sym] > 0.0f ? std::min(pdf[sym], 1.0f) : 0.0f;
+
+    if (p > 0) counters.ideal_bits -= std::log2(p / total);
+    counters.model_bits += PROB_BITS - std::log2((double) freq);
+
+    bool clamped = LEGACY_QUANTIZATION ? (uint32_t) (pdf[sym] * FLOATSHIFT) < MIN_PROBABILITY
+                                       : p / total * PROB_SCALE < 1.0;
+    if (clamped) counters.clamped++;
+
+    counters.coding_cycles -= rANSStatsClock() - start;
+}
+
+void rANSCoder::count_symbols(const uint32_t* syms, size_t n, const uint32_t* freqs) {
+    for (size_t i = 0; i < n; i++) {
+        count_symbol(freqs[syms[i]]);
     }
+}
 
-    cdf[0] = 0;
-    for(int i = 0; i<orpdf.size(); i++) {
-        cdf[i+1] = cdf[i] + npdf[i];
+void rANSCoder::count_escaped(const uint32_t* freqs, size_t n, size_t escapes) {
+    for (size_t i = 0; i < n; i++) {
+        count_symbol(freqs[i]);
     }
+    // every escaped residual follows in two raw halves, which cost exactly their bits
+    counters.ideal_bits += 2.0 * RANS_PARAMETRIC_RAW_BITS * escapes;
+    counters.model_bits += 2.0 * RANS_PARAMETRIC_RAW_BITS * escapes;
+}
+#endif
 
-    uint32_t cur_total = cdf[orpdf.size()];
-    for (int i = 1; i <= orpdf.size(); i++) {
-        // cdf has to be strictly increasing
-        cdf[i] = ((uint64_t)PROB_SCALE * cdf[i])/cur_total;
+rANSStats rANSCoder::stats() const {
+    rANSStats out = counters;
+    out.coding_cycles -= out.quantize_cycles;
+    return out;
+}
+
+void rANSCoder::reset_stats() {
+    counters = rANSStats();
+}
+
+void rANSCoder::set_legacy_quantization(bool legacy) {
+    LEGACY_QUANTIZATION = legacy;
+}
+
+bool rANSCoder::check_model(const rANSModel& model) const {
+    if (model.get_prob_bits() != PROB_BITS) {
+        std::cout << "ERROR: Model prob_bits (" << model.get_prob_bits() << ") do not match coder prob_bits ("
+                  << PROB_BITS << ")." << std::endl;
+        return false;
+    }
+    if (model.size() == 0) {
+        std::cout << "ERROR: Model is empty." << std::endl;
+        return false;
     }
+    return true;
+}
+
+bool rANSCoder::check_alphabet(size_t alphabet) const {
+    if (alphabet < 1 || alphabet > ((uint64_t) 1 << PROB_BITS)) {
+        std::cout << "ERROR: Distributions need 1 to 2^prob_bits symbols, got " << alphabet << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool rANSCoder::check_symbols(const uint32_t* syms, size_t n, const rANSModel& model) const {
+    const uint32_t* freqs = model.get_freqs();
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= model.size() || freqs[syms[i]] == 0) {
+            std::cout << "ERROR: Symbol " << i << " has a frequency of 0 in the model." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
 
-    for (int i = 0; i<orpdf.size(); i++) {
-        npdf[i] = cdf[i + 1] - cdf[i];
+bool rANSCoder::check_symbols(const uint32_t* syms, size_t n, size_t alphabet) const {
+    if (!check_alphabet(alphabet)) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= alphabet) {
+            std::cout << "ERROR: Symbol " << i << " is outside of the alphabet." << std::endl;
+            return false;
+        }
     }
+    return true;
+}
+
+bool rANSCoder::check_symbols(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet) const {
+    if (!check_symbols(syms, n, alphabet)) return false;
+    if (!LEGACY_QUANTIZATION) return true;
 
+    // the legacy quantization can round a probability down to 0, and such a symbol cannot be encoded
+    std::vector<uint32_t> npdf(alphabet);
+    std::vector<uint32_t> cdf(alphabet+1);
+    for (size_t i = 0; i < n; i++) {
+        convert_pdf(pdfs + i*alphabet, alphabet, npdf.data(), cdf.data());
+        if (npdf[syms[i]] == 0) {
+            std::cout << "ERROR: Symbol " << i << " has a frequency of 0 after the legacy quantization." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool rANSCoder::check_model(const rANSAdaptiveModel& model) const {
+    if (model.get_prob_bits() != PROB_BITS) {
+        std::cout << "ERROR: Model prob_bits (" << model.get_prob_bits() << ") do not match coder prob_bits ("
+                  << PROB_BITS << ")." << std::endl;
+        return false;
+    }
+    return true;
 }
 
 void rANSCoder::init_ec(){
     Rans64EncInit(&(this->state));
+    dc_view = nullptr;
+    dc_map.reset();
 }
 
 void rANSCoder::init_dc(uint32_t* dc_bs, size_t size) {
@@ -56,7 +287,17 @@ void rANSCoder::init_dc(uint32_t* dc_bs, size_t size) {
     }
 
     vec.assign(dc_bs, dc_bs+size);
+    dc_view = nullptr;
+    dc_map.reset();
+    dc_error = false;
 
+    if (vec.size() < 2) {
+        std::cout << "ERROR: Encoded buffer is too small." << std::endl;
+        vec.clear();
+        state = RANS64_L;
+        dc_error = true;
+        return;
+    }
     Rans64DecInit(&state, vec);
 }
 void rANSCoder::init_dc(std::vector<uint32_t> data) {
@@ -65,41 +306,742 @@ void rANSCoder::init_dc(std::vector<uint32_t> data) {
     }
 
     vec = data;
+    dc_view = nullptr;
+    dc_map.reset();
+    dc_error = false;
 
+    if (vec.size() < 2) {
+        std::cout << "ERROR: Encoded buffer is too small." << std::endl;
+        vec.clear();
+        state = RANS64_L;
+        dc_error = true;
+        return;
+    }
     Rans64DecInit(&state, vec);
 
 }
 
+void rANSCoder::init_dc_view(const uint32_t* data, size_t size) {
+    if(!flushed) {
+        std::cout << "ERROR: Trying to initialize decoder with unflushed buffer." << std::endl;
+    }
+    if (size < 2) {
+        // leave an empty view, every read from it fails instead of using a previous buffer
+        std::cout << "ERROR: Encoded buffer is too small." << std::endl;
+        vec.clear();
+        dc_view = nullptr;
+        dc_map.reset();
+        state = RANS64_L;
+        dc_error = true;
+        return;
+    }
+
+    dc_view = data;
+    dc_ptr = data + size;
+    dc_map.reset();
+    dc_error = false;
+
+    Rans64DecInitRev(&state, &dc_ptr);
+}
+
+bool rANSCoder::init_dc_mmap(const char* path) {
+    std::shared_ptr<rANSMappedFile> map = std::make_shared<rANSMappedFile>(path);
+    if (!map->is_open() || map->size() < 2) {
+        if (map->is_open()) std::cout << "ERROR: Encoded buffer is too small." << std::endl;
+        return false;
+    }
+
+    init_dc_view(map->data(), map->size());
+    dc_map = map;
+    return true;
+}
+
+const uint32_t* rANSCoder::dc_cursor() const {
+    return dc_view ? dc_ptr : vec.data() + vec.size();
+}
+
+const uint32_t* rANSCoder::dc_begin() const {
+    return dc_view ? dc_view : vec.data();
+}
+
+size_t rANSCoder::words_left() const {
+    return dc_cursor() - dc_begin();
+}
+
+bool rANSCoder::decode_failed() const {
+    return dc_error;
+}
+
+void rANSCoder::dc_commit(const uint32_t* ptr) {
+    if (dc_view) {
+        dc_ptr = ptr;
+    } else {
+        vec.resize(ptr - vec.data());
+    }
+}
+
 
 void rANSCoder::encode_sym(unsigned int sym, std::vector<float> pdf) {
+    const uint32_t s = sym;
+    if (!check_symbols(&s, pdf.data(), 1, pdf.size())) return;
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
 
     std::vector<uint32_t> npdf(pdf.size());
     std::vector<uint32_t> cdf(pdf.size()+1);
-    convert_pdf(pdf, npdf, cdf);
+    quantize_pdf(pdf.data(), pdf.size(), npdf.data(), cdf.data());
 
     Rans64EncPut(&state, vec, cdf[sym], npdf[sym], PROB_BITS);
     flushed = false;
 
+    RANS_STATS_ONLY(count_symbol(pdf.data(), sym, npdf[sym]);)
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, 1);)
+
+}
+
+void rANSCoder::encode_batch(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet) {
+    if (!check_symbols(syms, pdfs, n, alphabet)) return;
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
+
+    std::vector<uint32_t> npdf(alphabet);
+    std::vector<uint32_t> cdf(alphabet+1);
+
+    reserve(estimate_words(syms, pdfs, n, alphabet, PROB_BITS) + RANS_EC_CHUNK);
+
+    // rANS works like a stack, so encode backwards to decode in the original order
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_EC_CHUNK ? i - RANS_EC_CHUNK : 0;
+        uint32_t* ptr = ec_open(i - stop);
+        for (; i > stop; i--) {
+            quantize_pdf(pdfs + (i-1)*alphabet, alphabet, npdf.data(), cdf.data());
+            Rans64EncPutFwd(&state, &ptr, cdf[syms[i-1]], npdf[syms[i-1]], PROB_BITS);
+            RANS_STATS_ONLY(count_symbol(pdfs + (i-1)*alphabet, syms[i-1], npdf[syms[i-1]]);)
+        }
+        ec_close(ptr);
+    }
+    if (n > 0) flushed = false;
+
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, n);)
+
+}
+
+void rANSCoder::encode_sym(unsigned int sym, const rANSModel& model) {
+    const uint32_t s = sym;
+    if (!check_model(model) || !check_symbols(&s, 1, model)) return;
+
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
+    Rans64EncPutSymbol(&state, vec, model.get_enc_symbols() + sym, PROB_BITS);
+    flushed = false;
+
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, 1);)
+    RANS_STATS_ONLY(count_symbol(model.get_freqs()[sym]);)
+}
+
+void rANSCoder::encode_batch(const uint32_t* syms, size_t n, const rANSModel& model) {
+    if (!check_model(model) || !check_symbols(syms, n, model)) return;
+
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
+    reserve(model.estimate_words(syms, n) + RANS_EC_CHUNK);
+
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_EC_CHUNK ? i - RANS_EC_CHUNK : 0;
+        uint32_t* ptr = ec_open(i - stop);
+        encode_model_run(&state, &ptr, syms + stop, i - stop, model);
+        ec_close(ptr);
+        i = stop;
+    }
+    if (n > 0) flushed = false;
+
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, n);)
+    RANS_STATS_ONLY(count_symbols(syms, n, model.get_freqs());)
+}
+
+void rANSCoder::reserve(size_t words) {
+    vec.reserve(vec.size() + words);
+}
+
+uint32_t* rANSCoder::ec_open(size_t room) {
+    size_t pos = vec.size();
+    if (vec.capacity() < pos + room) {
+        // only happens when the output exceeds the estimate
+        vec.reserve(std::max(pos + room, vec.capacity() + vec.capacity() / 2));
+    }
+
+    vec.resize(pos + room);
+    return vec.data() + pos;
+}
+
+void rANSCoder::ec_close(uint32_t* ptr) {
+    vec.resize(ptr - vec.data());
 }
 
 uint32_t rANSCoder::decode_sym(std::vector<float> pdf) {
 
+    if (!check_alphabet(pdf.size())) return 0;
+
+    const uint32_t* ptr = dc_cursor();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
     uint32_t cum_prob = Rans64DecGet(&state, PROB_BITS);
 
     std::vector<uint32_t> npdf(pdf.size());
     std::vector<uint32_t> cdf(pdf.size()+1);
-    convert_pdf(pdf, npdf, cdf);
+    quantize_pdf(pdf.data(), pdf.size(), npdf.data(), cdf.data());
+
+    uint32_t sym = rANSFindSymbol(cdf.data(), pdf.size(), cum_prob);
 
-    uint32_t sym = 0;
-    while (cum_prob > cdf[sym] & cum_prob >= cdf[sym+1]) {
-        sym++;
+    if (!Rans64DecAdvanceRevBounded(&state, &ptr, dc_begin(), cdf[sym], npdf[sym], PROB_BITS)) {
+        decode_exhausted(&sym, 1, dc_error);
+        return sym;
     }
+    dc_commit(ptr);
 
-    Rans64DecAdvance(&state, vec, cdf[sym], npdf[sym], PROB_BITS);
+    RANS_STATS_ONLY(count_symbol(pdf.data(), sym, npdf[sym]);)
+    RANS_STATS_ONLY(count_call(start, begin - ptr, 1);)
 
     return sym;
 }
 
+void rANSCoder::decode_batch(const float* pdfs, size_t n, size_t alphabet, uint32_t* out) {
+    if (!check_alphabet(alphabet)) return;
+
+    std::vector<uint32_t> npdf(alphabet);
+    std::vector<uint32_t> cdf(alphabet+1);
+    const uint32_t* ptr = dc_cursor();
+    const uint32_t* bound = dc_begin();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t cum_prob = Rans64DecGet(&state, PROB_BITS);
+        quantize_pdf(pdfs + i*alphabet, alphabet, npdf.data(), cdf.data());
+
+        uint32_t sym = rANSFindSymbol(cdf.data(), alphabet, cum_prob);
+
+        if (!Rans64DecAdvanceRevBounded(&state, &ptr, bound, cdf[sym], npdf[sym], PROB_BITS)) {
+            decode_exhausted(out + i, n - i, dc_error);
+            RANS_STATS_ONLY(n = i;)
+            break;
+        }
+        out[i] = sym;
+        RANS_STATS_ONLY(count_symbol(pdfs + i*alphabet, sym, npdf[sym]);)
+    }
+
+    dc_commit(ptr);
+    RANS_STATS_ONLY(count_call(start, begin - ptr, n);)
+}
+
+uint32_t rANSCoder::decode_sym(const rANSModel& model) {
+    if (!check_model(model)) return 0;
+
+    const uint32_t* ptr = dc_cursor();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+    uint32_t cum_prob = Rans64DecGet(&state, PROB_BITS);
+
+    const rANSDecSlot* slots = model.get_slots();
+    if (slots) {
+        const rANSDecSlot& slot = slots[cum_prob];
+        uint32_t sym = slot.sym;
+        if (!Rans64DecAdvanceRevBounded(&state, &ptr, dc_begin(), slot.start, slot.freq, PROB_BITS)) {
+            decode_exhausted(&sym, 1, dc_error);
+            return sym;
+        }
+        dc_commit(ptr);
+        RANS_STATS_ONLY(count_call(start, begin - ptr, 1);)
+        RANS_STATS_ONLY(count_symbol(slot.freq);)
+        return sym;
+    }
+
+    uint32_t sym = model.find_symbol(cum_prob);
+    if (!Rans64DecAdvanceRevBounded(&state, &ptr, dc_begin(), model.get_cdf()[sym], model.get_freqs()[sym],
+                                    PROB_BITS)) {
+        decode_exhausted(&sym, 1, dc_error);
+        return sym;
+    }
+    dc_commit(ptr);
+
+    RANS_STATS_ONLY(count_call(start, begin - ptr, 1);)
+    RANS_STATS_ONLY(count_symbol(model.get_freqs()[sym]);)
+
+    return sym;
+}
+
+void rANSCoder::decode_batch(const rANSModel& model, size_t n, uint32_t* out) {
+    if (!check_model(model)) return;
+
+    const uint32_t* ptr = dc_cursor();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+    size_t done = decode_model_run(&state, &ptr, dc_begin(), model, n, out);
+    dc_commit(ptr);
+    if (done < n) {
+        decode_exhausted(out + done, n - done, dc_error);
+        RANS_STATS_ONLY(n = done;)
+    }
+
+    RANS_STATS_ONLY(count_call(start, begin - ptr, n);)
+    RANS_STATS_ONLY(count_symbols(out, n, model.get_freqs());)
+}
+
+void rANSCoder::encode_batch(const uint32_t* syms, size_t n, rANSAdaptiveModel& model) {
+    if (!check_model(model)) return;
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= model.size()) {
+            std::cout << "ERROR: Symbol " << i << " is outside of the model's alphabet." << std::endl;
+            return;
+        }
+    }
+
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
+
+    // run the model forwards like the decoder will, keeping the range every symbol is coded with
+    std::vector<uint32_t> ranges(2*n);
+    uint64_t bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t freq = model.get_freqs()[syms[i]];
+        ranges[2*i] = model.get_cdf()[syms[i]];
+        ranges[2*i+1] = freq;
+        bits += rANSSymbolCost(freq, PROB_BITS);
+        model.update(syms[i]);
+    }
+
+    reserve(rANSCostWords(bits) + RANS_EC_CHUNK);
+
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_EC_CHUNK ? i - RANS_EC_CHUNK : 0;
+        uint32_t* ptr = ec_open(i - stop);
+        for (; i > stop; i--) {
+            Rans64EncPutFwd(&state, &ptr, ranges[2*i-2], ranges[2*i-1], PROB_BITS);
+        }
+        ec_close(ptr);
+    }
+    if (n > 0) flushed = false;
+
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, n);)
+    RANS_STATS_ONLY(for (size_t i = 0; i < n; i++) count_symbol(ranges[2*i+1]);)
+}
+
+uint32_t rANSCoder::decode_sym(rANSAdaptiveModel& model) {
+    if (!check_model(model)) return 0;
+
+    const uint32_t* ptr = dc_cursor();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+    uint32_t sym = model.find_symbol(Rans64DecGet(&state, PROB_BITS));
+    if (!Rans64DecAdvanceRevBounded(&state, &ptr, dc_begin(), model.get_cdf()[sym], model.get_freqs()[sym],
+                                    PROB_BITS)) {
+        decode_exhausted(&sym, 1, dc_error);
+        return sym;
+    }
+    dc_commit(ptr);
+
+    RANS_STATS_ONLY(const uint32_t freq = model.get_freqs()[sym];)
+    model.update(sym);
+    RANS_STATS_ONLY(count_call(start, begin - ptr, 1);)
+    RANS_STATS_ONLY(count_symbol(freq);)
+    return sym;
+}
+
+void rANSCoder::decode_batch(rANSAdaptiveModel& model, size_t n, uint32_t* out) {
+    if (!check_model(model)) return;
+
+    const uint32_t* ptr = dc_cursor();
+    const uint32_t* bound = dc_begin();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+    // the model changes with every symbol, keep the frequencies to cost them after the timed loop
+    RANS_STATS_ONLY(std::vector<uint32_t> freqs(n);)
+    for (size_t i = 0; i < n; i++) {
+        uint32_t sym = model.find_symbol(Rans64DecGet(&state, PROB_BITS));
+        if (!Rans64DecAdvanceRevBounded(&state, &ptr, bound, model.get_cdf()[sym], model.get_freqs()[sym], PROB_BITS)) {
+            decode_exhausted(out + i, n - i, dc_error);
+            RANS_STATS_ONLY(n = i;)
+            break;
+        }
+        RANS_STATS_ONLY(freqs[i] = model.get_freqs()[sym];)
+        model.update(sym);
+        out[i] = sym;
+    }
+    dc_commit(ptr);
+
+    RANS_STATS_ONLY(count_call(start, begin - ptr, n);)
+    RANS_STATS_ONLY(for (size_t i = 0; i < n; i++) count_symbol(freqs[i]);)
+}
+
+bool rANSCoder::check_cdfs(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet) const {
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t* cdf = cdfs + i*(alphabet+1);
+        if (cdf[alphabet] != PROB_SCALE) {
+            std::cout << "ERROR: Cdf " << i << " sums to " << cdf[alphabet] << " instead of " << PROB_SCALE << "."
+                      << std::endl;
+            return false;
+        }
+        if (syms && syms[i] >= alphabet) {
+            std::cout << "ERROR: Symbol " << i << " is outside of the alphabet." << std::endl;
+            return false;
+        }
+        if (syms && cdf[syms[i]+1] <= cdf[syms[i]]) {
+            std::cout << "ERROR: Symbol " << i << " has a frequency of 0 in its cdf." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void rANSCoder::encode_sym_cdf(unsigned int sym, const uint32_t* cdf, size_t alphabet) {
+    const uint32_t s = sym;
+    if (!check_cdfs(&s, cdf, 1, alphabet)) return;
+
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
+    Rans64EncPut(&state, vec, cdf[sym], cdf[sym+1] - cdf[sym], PROB_BITS);
+    flushed = false;
+
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, 1);)
+    RANS_STATS_ONLY(count_symbol(cdf[sym+1] - cdf[sym]);)
+}
+
+void rANSCoder::encode_batch_cdf(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet) {
+    if (!check_cdfs(syms, cdfs, n, alphabet)) return;
+
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
+    const size_t stride = alphabet+1;
+    reserve(estimate_words(syms, cdfs, n, alphabet, PROB_BITS) + RANS_EC_CHUNK);
+
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_EC_CHUNK ? i - RANS_EC_CHUNK : 0;
+        uint32_t* ptr = ec_open(i - stop);
+        encode_cdf_run(&state, &ptr, syms + stop, cdfs + stop*stride, i - stop, alphabet, PROB_BITS);
+        ec_close(ptr);
+        i = stop;
+    }
+    if (n > 0) flushed = false;
+
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, n);)
+    RANS_STATS_ONLY(for (size_t i = 0; i < n; i++) count_symbol(cdfs[i*stride + syms[i]+1] - cdfs[i*stride + syms[i]]);)
+}
+
+uint32_t rANSCoder::decode_sym_cdf(const uint32_t* cdf, size_t alphabet) {
+    if (!check_cdfs(nullptr, cdf, 1, alphabet)) return 0;
+
+    const uint32_t* ptr = dc_cursor();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+
+    uint32_t sym = rANSFindSymbol(cdf, alphabet, Rans64DecGet(&state, PROB_BITS));
+    if (!Rans64DecAdvanceRevBounded(&state, &ptr, dc_begin(), cdf[sym], cdf[sym+1] - cdf[sym], PROB_BITS)) {
+        decode_exhausted(&sym, 1, dc_error);
+        return sym;
+    }
+    dc_commit(ptr);
+
+    RANS_STATS_ONLY(count_call(start, begin - ptr, 1);)
+    RANS_STATS_ONLY(count_symbol(cdf[sym+1] - cdf[sym]);)
+
+    return sym;
+}
+
+void rANSCoder::decode_batch_cdf(const uint32_t* cdfs, size_t n, size_t alphabet, uint32_t* out) {
+    if (!check_cdfs(nullptr, cdfs, n, alphabet)) return;
+
+    const uint32_t* ptr = dc_cursor();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+    size_t done = decode_cdf_run(&state, &ptr, dc_begin(), cdfs, n, alphabet, PROB_BITS, out);
+    dc_commit(ptr);
+    if (done < n) {
+        decode_exhausted(out + done, n - done, dc_error);
+        RANS_STATS_ONLY(n = done;)
+    }
+
+    RANS_STATS_ONLY(const size_t stride = alphabet+1;)
+    RANS_STATS_ONLY(count_call(start, begin - ptr, n);)
+    RANS_STATS_ONLY(for (size_t i = 0; i < n; i++) count_symbol(cdfs[i*stride + out[i]+1] - cdfs[i*stride + out[i]]);)
+}
+
+bool rANSCoder::check_bank(const uint32_t* scale_indices, size_t n, const rANSParametricBank& bank) const {
+    if (bank.get_prob_bits() != PROB_BITS) {
+        std::cout << "ERROR: Bank prob_bits (" << bank.get_prob_bits() << ") do not match coder prob_bits ("
+                  << PROB_BITS << ")." << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (scale_indices[i] >= bank.size()) {
+            std::cout << "ERROR: Scale index " << i << " is outside of the bank." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rounds a predicted mean to the integer the residuals are taken against, the same way on both sides.
+static inline int32_t round_mean(float mean) {
+    if (!(std::fabs(mean) < 1e9f)) return 0;
+    return (int32_t) std::floor(mean + 0.5f);
+}
+
+void rANSCoder::encode_batch_parametric(const int32_t* syms, const float* means, const uint32_t* scale_indices,
+                                        size_t n, const rANSParametricBank& bank) {
+    if (!check_bank(scale_indices, n, bank)) return;
+
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const size_t words = vec.size();)
+    RANS_STATS_ONLY(std::vector<uint32_t> freqs(n); size_t escapes = 0;)
+    uint64_t bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t index = scale_indices[i];
+        uint32_t tail = bank.get_tail(index);
+        uint32_t offset = (uint32_t) syms[i] - (uint32_t) round_mean(means[i]) + tail;
+        uint32_t sym = offset <= 2 * tail ? offset : 2 * tail + 1;
+        if (sym > 2 * tail) bits += (uint64_t) 2 * RANS_PARAMETRIC_RAW_BITS << RANS_COST_BITS;
+        bits += rANSSymbolCost(bank.get_enc_symbols(index)[sym].freq, PROB_BITS);
+        RANS_STATS_ONLY(freqs[i] = bank.get_enc_symbols(index)[sym].freq; escapes += sym > 2 * tail;)
+    }
+    reserve(rANSCostWords(bits) + 3 * RANS_EC_CHUNK);
+
+    const uint32_t raw_mask = (1u << RANS_PARAMETRIC_RAW_BITS) - 1;
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_EC_CHUNK ? i - RANS_EC_CHUNK : 0;
+        // an escaped symbol takes up to three steps
+        uint32_t* ptr = ec_open(3 * (i - stop));
+        for (; i > stop; i--) {
+            uint32_t index = scale_indices[i-1];
+            uint32_t tail = bank.get_tail(index);
+            uint32_t residual = (uint32_t) syms[i-1] - (uint32_t) round_mean(means[i-1]);
+            uint32_t offset = residual + tail;
+            uint32_t sym = offset;
+            if (offset > 2 * tail) {
+                // the decoder reads the escape first, then the low and the high half of the residual
+                Rans64EncPutFwd(&state, &ptr, residual >> RANS_PARAMETRIC_RAW_BITS, 1, RANS_PARAMETRIC_RAW_BITS);
+                Rans64EncPutFwd(&state, &ptr, residual & raw_mask, 1, RANS_PARAMETRIC_RAW_BITS);
+                sym = 2 * tail + 1;
+            }
+            Rans64EncPutSymbolFwd(&state, &ptr, bank.get_enc_symbols(index) + sym, PROB_BITS);
+        }
+        ec_close(ptr);
+    }
+    if (n > 0) flushed = false;
+
+    RANS_STATS_ONLY(count_call(start, vec.size() - words, n);)
+    RANS_STATS_ONLY(count_escaped(freqs.data(), n, escapes);)
+}
+
+void rANSCoder::decode_batch_parametric(const float* means, const uint32_t* scale_indices, size_t n,
+                                        const rANSParametricBank& bank, int32_t* out) {
+    if (!check_bank(scale_indices, n, bank)) return;
+
+    const uint32_t* ptr = dc_cursor();
+    const uint32_t* bound = dc_begin();
+    RANS_STATS_ONLY(const uint64_t start = rANSStatsClock(); const uint32_t* begin = ptr;)
+    RANS_STATS_ONLY(std::vector<uint32_t> freqs(n); size_t escapes = 0;)
+    for (size_t i = 0; i < n; i++) {
+        uint32_t index = scale_indices[i];
+        uint32_t tail = bank.get_tail(index);
+        const uint32_t* cdf = bank.get_cdf(index);
+        uint32_t sym = bank.find_symbol(index, Rans64DecGet(&state, PROB_BITS));
+        bool ok = Rans64DecAdvanceRevBounded(&state, &ptr, bound, cdf[sym], cdf[sym+1] - cdf[sym], PROB_BITS);
+        RANS_STATS_ONLY(freqs[i] = cdf[sym+1] - cdf[sym]; escapes += sym > 2 * tail;)
+
+        uint32_t residual = sym - tail;
+        if (ok && sym > 2 * tail) {
+            uint32_t low = Rans64DecGet(&state, RANS_PARAMETRIC_RAW_BITS);
+            ok = Rans64DecAdvanceRevBounded(&state, &ptr, bound, low, 1, RANS_PARAMETRIC_RAW_BITS);
+            uint32_t high = Rans64DecGet(&state, RANS_PARAMETRIC_RAW_BITS);
+            ok = ok && Rans64DecAdvanceRevBounded(&state, &ptr, bound, high, 1, RANS_PARAMETRIC_RAW_BITS);
+            residual = high << RANS_PARAMETRIC_RAW_BITS | low;
+        }
+        if (!ok) {
+            decode_exhausted(out + i, n - i, dc_error);
+            RANS_STATS_ONLY(n = i;)
+            break;
+        }
+        out[i] = (int32_t) (residual + (uint32_t) round_mean(means[i]));
+    }
+    dc_commit(ptr);
+
+    RANS_STATS_ONLY(count_call(start, begin - ptr, n);)
+    RANS_STATS_ONLY(count_escaped(freqs.data(), n, escapes);)
+}
+
+template <uint32_t N>
+static void encode_interleaved_n(const uint32_t* syms, size_t n, const rANSModel& model, std::vector<uint32_t>& out) {
+    const uint32_t prob_bits = model.get_prob_bits();
+    const Rans64EncSymbol* enc_syms = model.get_enc_symbols();
+
+    Rans64State states[N];
+    for (uint32_t k = 0; k < N; k++) {
+        Rans64EncInit(&states[k]);
+    }
+
+    // symbol i is coded with state i % N, backwards so the decoder runs forwards
+    size_t full = n - n % N;
+    for (size_t i = n; i-- > full;) {
+        Rans64EncPutSymbol(&states[i - full], out, enc_syms + syms[i], prob_bits);
+    }
+    for (size_t i = full; i > 0; i -= N) {
+        for (uint32_t k = N; k-- > 0;) {
+            Rans64EncPutSymbol(&states[k], out, enc_syms + syms[i - N + k], prob_bits);
+        }
+    }
+
+    for (uint32_t k = N; k-- > 0;) {
+        Rans64EncFlush(&states[k], out);
+    }
+}
+
+// Decodes the payload [begin, end) of N interleaved states. Returns the cursor after the last symbol, or nullptr when a
+// symbol would need a word before begin.
+template <uint32_t N>
+static const uint32_t* decode_interleaved_n(const uint32_t* begin, const uint32_t* end, const rANSModel& model,
+                                            size_t n, uint32_t* out) {
+    const uint32_t prob_bits = model.get_prob_bits();
+    const rANSDecSlot* slots = model.get_slots();
+    const uint32_t* cdf = model.get_cdf();
+    const uint32_t* freqs = model.get_freqs();
+    const uint32_t* ptr = end;
+
+    Rans64State states[N];
+    for (uint32_t k = 0; k < N; k++) {
+        Rans64DecInitRev(&states[k], &ptr);
+    }
+
+    size_t full = n - n % N;
+    for (size_t i = 0; i < full; i += N) {
+        for (uint32_t k = 0; k < N; k++) {
+            uint32_t cum_prob = Rans64DecGet(&states[k], prob_bits);
+            if (slots) {
+                Rans64DecAdvanceStep(&states[k], slots[cum_prob].start, slots[cum_prob].freq, prob_bits);
+                out[i + k] = slots[cum_prob].sym;
+            } else {
+                uint32_t sym = model.find_symbol(cum_prob);
+                Rans64DecAdvanceStep(&states[k], cdf[sym], freqs[sym], prob_bits);
+                out[i + k] = sym;
+            }
+        }
+        for (uint32_t k = 0; k < N; k++) {
+            if (!Rans64DecRenormRevBounded(&states[k], &ptr, begin)) return nullptr;
+        }
+    }
+    for (size_t i = full; i < n; i++) {
+        uint32_t sym = model.find_symbol(Rans64DecGet(&states[i - full], prob_bits));
+        if (!Rans64DecAdvanceRevBounded(&states[i - full], &ptr, begin, cdf[sym], freqs[sym], prob_bits)) {
+            return nullptr;
+        }
+        out[i] = sym;
+    }
+
+    return ptr;
+}
+
+std::vector<uint32_t> rANSCoder::encode_interleaved(const uint32_t* syms, size_t n, const rANSModel& model, uint32_t ways) {
+    std::vector<uint32_t> out;
+    if (!check_model(model) || !check_symbols(syms, n, model)) return out;
+
+    out.reserve(model.estimate_words(syms, n) + 2*ways);
+    out.push_back(RANS_FORMAT_MARKER(RANS_FORMAT_INTERLEAVED, ways));
+    switch (ways) {
+        case 1: encode_interleaved_n<1>(syms, n, model, out); break;
+        case 2: encode_interleaved_n<2>(syms, n, model, out); break;
+        case 4: encode_interleaved_n<4>(syms, n, model, out); break;
+        case 8: encode_interleaved_n<8>(syms, n, model, out); break;
+        default:
+            std::cout << "ERROR: Unsupported number of interleaved states: " << ways << "." << std::endl;
+            out.clear();
+    }
+    return out;
+}
+
+void rANSCoder::decode_interleaved(const uint32_t* data, size_t size, const rANSModel& model, size_t n, uint32_t* out) {
+    if (!check_model(model)) return;
+
+    if (size > 0 && RANS_FORMAT_IS(data[0], RANS_FORMAT_WIDE)) {
+        decode_wide(data, size, model, n, out);
+        return;
+    }
+
+    if (size == 0 || !RANS_FORMAT_IS(data[0], RANS_FORMAT_INTERLEAVED)) {
+        std::cout << "ERROR: Buffer is not an interleaved stream." << std::endl;
+        return;
+    }
+
+    uint32_t ways = data[0] & 0xff;
+    if (size < 1 + 2 * (size_t)ways) {
+        std::cout << "ERROR: Interleaved stream is truncated." << std::endl;
+        return;
+    }
+
+    const uint32_t* end = data + size;
+    switch (ways) {
+        case 1: end = decode_interleaved_n<1>(data + 1, end, model, n, out); break;
+        case 2: end = decode_interleaved_n<2>(data + 1, end, model, n, out); break;
+        case 4: end = decode_interleaved_n<4>(data + 1, end, model, n, out); break;
+        case 8: end = decode_interleaved_n<8>(data + 1, end, model, n, out); break;
+        default:
+            std::cout << "ERROR: Unsupported number of interleaved states: " << ways << "." << std::endl;
+            return;
+    }
+
+    if (!end) {
+        std::cout << "ERROR: Interleaved stream ended before all symbols were decoded." << std::endl;
+    } else if (end != data + 1) {
+        std::cout << "ERROR: Interleaved stream was not consumed exactly, wrong model or symbol count?" << std::endl;
+    }
+}
+
+std::vector<uint32_t> rANSCoder::encode_wide(const uint32_t* syms, size_t n, const rANSModel& model, uint32_t lanes) {
+    std::vector<uint32_t> out;
+    if (!check_model(model) || !check_symbols(syms, n, model)) return out;
+
+    if (PROB_BITS > RANS_WIDE_MAX_BITS || !model.get_slots()) {
+        std::cout << "ERROR: Wide-lane coding needs prob_bits of at most " << RANS_WIDE_MAX_BITS << "." << std::endl;
+        return out;
+    }
+    if (lanes != 8 && lanes != 16) {
+        std::cout << "ERROR: Unsupported number of lanes: " << lanes << "." << std::endl;
+        return out;
+    }
+
+    rANSWideEncode(syms, n, model, lanes, out);
+    return out;
+}
+
+void rANSCoder::decode_wide(const uint32_t* data, size_t size, const rANSModel& model, size_t n, uint32_t* out) {
+    if (!check_model(model)) return;
+
+    if (!rANSWideDecode(data, size, model, n, out)) {
+        std::cout << "ERROR: Wide-lane stream is malformed or does not match the model and symbol count." << std::endl;
+    }
+}
+
+bool rANSCoder::check_tans(const rANSTansTable& table) const {
+    if (PROB_BITS < RANS_TANS_MIN_BITS || PROB_BITS > RANS_TANS_MAX_BITS) {
+        std::cout << "ERROR: tANS coding needs " << RANS_TANS_MIN_BITS << " to " << RANS_TANS_MAX_BITS
+                  << " prob_bits." << std::endl;
+        return false;
+    }
+    if (table.size() == 0 || table.get_prob_bits() != PROB_BITS) {
+        std::cout << "ERROR: tANS table prob_bits (" << table.get_prob_bits() << ") do not match coder prob_bits ("
+                  << PROB_BITS << ")." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<uint32_t> rANSCoder::encode_tans(const uint32_t* syms, size_t n, const rANSTansTable& table) {
+    std::vector<uint32_t> out;
+    if (!check_tans(table)) return out;
+    uint64_t bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= table.size() || table.get_freqs()[syms[i]] == 0) {
+            std::cout << "ERROR: Symbol " << i << " has a frequency of 0 in the model." << std::endl;
+            return out;
+        }
+        bits += rANSSymbolCost(table.get_freqs()[syms[i]], PROB_BITS);
+    }
+
+    out.reserve(rANSCostWords(bits) + RANS_TANS_HEADER_WORDS);
+    rANSTansEncode(syms, n, table, out);
+    return out;
+}
+
+void rANSCoder::decode_tans(const uint32_t* data, size_t size, const rANSTansTable& table, size_t n, uint32_t* out) {
+    if (!check_tans(table)) return;
+    if (!rANSTansDecode(data, size, table, n, out)) {
+        std::cout << "ERROR: tANS stream is malformed or was not consumed exactly, wrong model or symbol count?"
+                  << std::endl;
+    }
+}
+
 void rANSCoder::get_buffer(uint32_t** addr, size_t& size) {
     if (!flushed) Rans64EncFlush(&state, vec);
     *addr = vec.data();
@@ -112,4 +1054,544 @@ std::vector<uint32_t> rANSCoder::get_buffer() {
     if (!flushed) Rans64EncFlush(&state, vec);
     Rans64EncInit(&(this->state));
     return vec;
-}
\ No newline at end of file
+}
+
+std::vector<uint32_t> rANSCoder::release_buffer() {
+    if (!flushed) Rans64EncFlush(&state, vec);
+    Rans64EncInit(&(this->state));
+    flushed = true;
+
+    std::vector<uint32_t> out;
+    out.swap(vec);
+    return out;
+}
+void rANSCoder::set_num_threads(unsigned threads) {
+    if (threads != num_threads) {
+        num_threads = threads;
+        pool.reset();
+    }
+}
+
+rANSThreadPool& rANSCoder::get_pool() {
+    if (!pool) {
+        pool = std::make_shared<rANSThreadPool>(num_threads);
+    }
+    return *pool;
+}
+
+void rANSCoder::encode_block(const uint32_t* syms, const float* pdfs, size_t alphabet, const rANSModel* model,
+                             size_t first, size_t last, std::vector<uint32_t>& out) const {
+    Rans64State block_state;
+    Rans64EncInit(&block_state);
+
+    out.reserve(model ? model->estimate_words(syms + first, last - first)
+                      : estimate_words(syms + first, pdfs + first*alphabet, last - first, alphabet, PROB_BITS));
+    if (model) {
+        const Rans64EncSymbol* enc_syms = model->get_enc_symbols();
+        for (size_t i = last; i-- > first;) {
+            Rans64EncPutSymbol(&block_state, out, enc_syms + syms[i], PROB_BITS);
+        }
+    } else {
+        std::vector<uint32_t> npdf(alphabet);
+        std::vector<uint32_t> cdf(alphabet+1);
+        for (size_t i = last; i-- > first;) {
+            convert_pdf(pdfs + i*alphabet, alphabet, npdf.data(), cdf.data());
+            Rans64EncPut(&block_state, out, cdf[syms[i]], npdf[syms[i]], PROB_BITS);
+        }
+    }
+
+    Rans64EncFlush(&block_state, out);
+}
+
+bool rANSCoder::decode_block(const uint32_t* begin, const uint32_t* end, const float* pdfs, size_t alphabet,
+                             const rANSModel* model, size_t first, size_t last, uint32_t* out) const {
+    if (end - begin < 2) return false;
+
+    const uint32_t* ptr = end;
+    Rans64State block_state;
+    Rans64DecInitRev(&block_state, &ptr);
+
+    if (model) {
+        const rANSDecSlot* slots = model->get_slots();
+        const uint32_t* cdf = model->get_cdf();
+        const uint32_t* freqs = model->get_freqs();
+        for (size_t i = first; i < last; i++) {
+            uint32_t cum_prob = Rans64DecGet(&block_state, PROB_BITS);
+            if (slots) {
+                const rANSDecSlot& slot = slots[cum_prob];
+                if (!Rans64DecAdvanceRevBounded(&block_state, &ptr, begin, slot.start, slot.freq, PROB_BITS)) {
+                    return false;
+                }
+                out[i - first] = slot.sym;
+            } else {
+                uint32_t sym = model->find_symbol(cum_prob);
+                if (!Rans64DecAdvanceRevBounded(&block_state, &ptr, begin, cdf[sym], freqs[sym], PROB_BITS)) {
+                    return false;
+                }
+                out[i - first] = sym;
+            }
+        }
+    } else {
+        std::vector<uint32_t> npdf(alphabet);
+        std::vector<uint32_t> cdf(alphabet+1);
+        for (size_t i = first; i < last; i++) {
+            uint32_t cum_prob = Rans64DecGet(&block_state, PROB_BITS);
+            convert_pdf(pdfs + i*alphabet, alphabet, npdf.data(), cdf.data());
+            uint32_t sym = rANSFindSymbol(cdf.data(), alphabet, cum_prob);
+            if (!Rans64DecAdvanceRevBounded(&block_state, &ptr, begin, cdf[sym], npdf[sym], PROB_BITS)) return false;
+            out[i - first] = sym;
+        }
+    }
+
+    return ptr == begin;
+}
+
+static inline uint64_t read_u64(const uint32_t* p) {
+    return (uint64_t) p[0] | ((uint64_t) p[1] << 32);
+}
+
+static inline void write_u64(uint32_t* p, uint64_t v) {
+    p[0] = (uint32_t) v;
+    p[1] = (uint32_t) (v >> 32);
+}
+
+// Checks that the blocks of a container hold its symbols exactly and that its index fits. n is never rounded up to
+// whole blocks, which could wrap around for a crafted header.
+static bool blocks_header_ok(const uint32_t* data, size_t size) {
+    uint64_t n = read_u64(data + 1);
+    uint64_t block_size = data[3];
+    uint64_t num_blocks = data[4];
+    return block_size > 0 && n <= num_blocks * block_size && (num_blocks == 0 || n > (num_blocks - 1) * block_size) &&
+           (size - RANS_BLOCKS_HEADER_WORDS) / RANS_BLOCKS_INDEX_WORDS >= num_blocks;
+}
+
+size_t rANSCoder::num_block_symbols(const uint32_t* data, size_t size) {
+    if (size < RANS_BLOCKS_HEADER_WORDS || data[0] != RANS_FORMAT_MARKER(RANS_FORMAT_BLOCKS, RANS_BLOCKS_VERSION) ||
+        !blocks_header_ok(data, size)) {
+        return 0;
+    }
+    return read_u64(data + 1);
+}
+
+std::vector<uint32_t> rANSCoder::encode_blocks_impl(const uint32_t* syms, const float* pdfs, size_t alphabet,
+                                                    const rANSModel* model, size_t n, size_t block_size) {
+    std::vector<uint32_t> out;
+    if (block_size == 0 || block_size > 0xffffffffu) {
+        std::cout << "ERROR: Block size must be between 1 and 2^32-1 symbols." << std::endl;
+        return out;
+    }
+
+    size_t num_blocks = (n + block_size - 1) / block_size;
+    std::vector<std::vector<uint32_t> > blocks(num_blocks);
+    get_pool().parallel_for(num_blocks, [&](size_t b) {
+        size_t first = b * block_size;
+        size_t last = std::min(n, first + block_size);
+        blocks[b].reserve((last - first) / 4 + 2);
+        encode_block(syms, pdfs, alphabet, model, first, last, blocks[b]);
+    });
+
+    size_t payload = RANS_BLOCKS_HEADER_WORDS + num_blocks * RANS_BLOCKS_INDEX_WORDS;
+    size_t total = payload;
+    for (size_t b = 0; b < num_blocks; b++) {
+        total += blocks[b].size();
+    }
+
+    out.resize(total);
+    out[0] = RANS_FORMAT_MARKER(RANS_FORMAT_BLOCKS, RANS_BLOCKS_VERSION);
+    write_u64(&out[1], n);
+    out[3] = (uint32_t) block_size;
+    out[4] = (uint32_t) num_blocks;
+
+    uint64_t offset = 0;
+    for (size_t b = 0; b < num_blocks; b++) {
+        uint32_t* entry = &out[RANS_BLOCKS_HEADER_WORDS + b * RANS_BLOCKS_INDEX_WORDS];
+        write_u64(entry, offset);
+        entry[2] = (uint32_t) blocks[b].size();
+        std::copy(blocks[b].begin(), blocks[b].end(), out.begin() + payload + offset);
+        offset += blocks[b].size();
+    }
+
+    return out;
+}
+
+std::vector<uint32_t> rANSCoder::encode_blocks(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet,
+                                               size_t block_size) {
+    if (!check_symbols(syms, pdfs, n, alphabet)) return std::vector<uint32_t>();
+    return encode_blocks_impl(syms, pdfs, alphabet, nullptr, n, block_size);
+}
+
+std::vector<uint32_t> rANSCoder::encode_blocks(const uint32_t* syms, size_t n, const rANSModel& model,
+                                               size_t block_size) {
+    if (!check_model(model) || !check_symbols(syms, n, model)) return std::vector<uint32_t>();
+    return encode_blocks_impl(syms, nullptr, 0, &model, n, block_size);
+}
+
+void rANSCoder::decode_blocks_impl(const uint32_t* data, size_t size, const float* pdfs, size_t alphabet,
+                                   const rANSModel* model, size_t range_begin, size_t range_end, uint32_t* out) {
+    if (size < RANS_BLOCKS_HEADER_WORDS || data[0] != RANS_FORMAT_MARKER(RANS_FORMAT_BLOCKS, RANS_BLOCKS_VERSION)) {
+        std::cout << "ERROR: Buffer is not a block container." << std::endl;
+        return;
+    }
+
+    if (!blocks_header_ok(data, size)) {
+        std::cout << "ERROR: Block container header is corrupt." << std::endl;
+        return;
+    }
+
+    size_t n = read_u64(data + 1);
+    size_t block_size = data[3];
+    size_t num_blocks = data[4];
+    size_t payload = RANS_BLOCKS_HEADER_WORDS + num_blocks * RANS_BLOCKS_INDEX_WORDS;
+
+    range_end = std::min(range_end, n);
+    if (range_begin >= range_end) return;
+
+    // only the blocks overlapping [range_begin, range_end) are decoded
+    size_t first_block = range_begin / block_size;
+    size_t last_block = (range_end - 1) / block_size + 1;
+
+    std::atomic<bool> ok(true);
+    get_pool().parallel_for(last_block - first_block, [&](size_t k) {
+        size_t b = first_block + k;
+        const uint32_t* entry = data + RANS_BLOCKS_HEADER_WORDS + b * RANS_BLOCKS_INDEX_WORDS;
+        uint64_t offset = read_u64(entry);
+        if (offset > size - payload || entry[2] > size - payload - offset) {
+            ok = false;
+            return;
+        }
+        const uint32_t* begin = data + payload + offset;
+        size_t first = b * block_size;
+        size_t last = std::min(n, first + block_size);
+
+        if (first >= range_begin && last <= range_end) {
+            if (!decode_block(begin, begin + entry[2], pdfs, alphabet, model, first, last,
+                              out + (first - range_begin))) {
+                ok = false;
+            }
+            return;
+        }
+
+        // block sticking out of the range, decode it whole and keep the overlap
+        std::vector<uint32_t> tmp(last - first);
+        if (!decode_block(begin, begin + entry[2], pdfs, alphabet, model, first, last, tmp.data())) {
+            ok = false;
+        }
+        size_t from = std::max(first, range_begin);
+        size_t to = std::min(last, range_end);
+        std::copy(tmp.begin() + (from - first), tmp.begin() + (to - first), out + (from - range_begin));
+    });
+
+    if (!ok) {
+        std::cout << "ERROR: Block container is corrupt or does not match the distributions." << std::endl;
+    }
+}
+
+void rANSCoder::decode_blocks(const uint32_t* data, size_t size, const float* pdfs, size_t alphabet, uint32_t* out) {
+    if (!check_alphabet(alphabet)) return;
+    decode_blocks_impl(data, size, pdfs, alphabet, nullptr, 0, SIZE_MAX, out);
+}
+
+void rANSCoder::decode_blocks(const uint32_t* data, size_t size, const rANSModel& model, uint32_t* out) {
+    if (!check_model(model)) return;
+    decode_blocks_impl(data, size, nullptr, 0, &model, 0, SIZE_MAX, out);
+}
+
+void rANSCoder::decode_range(const uint32_t* data, size_t size, const float* pdfs, size_t alphabet,
+                             size_t begin, size_t end, uint32_t* out) {
+    if (!check_alphabet(alphabet)) return;
+    decode_blocks_impl(data, size, pdfs, alphabet, nullptr, begin, end, out);
+}
+
+void rANSCoder::decode_range(const uint32_t* data, size_t size, const rANSModel& model,
+                             size_t begin, size_t end, uint32_t* out) {
+    if (!check_model(model)) return;
+    decode_blocks_impl(data, size, nullptr, 0, &model, begin, end, out);
+}
+
+std::vector<uint32_t> rANSCoder::encode_context(const uint32_t* syms, size_t n, size_t alphabet, uint32_t order,
+                                                bool adaptive) {
+    std::vector<uint32_t> out;
+    if (order < 1 || order > 2) {
+        std::cout << "ERROR: Unsupported context order: " << order << "." << std::endl;
+        return out;
+    }
+    if (alphabet < 1 || alphabet > RANS_CONTEXT_MAX_ALPHABET || PROB_BITS < 1 || PROB_BITS > RANS_CONTEXT_MAX_BITS ||
+        alphabet > ((size_t) 1 << PROB_BITS)) {
+        std::cout << "ERROR: Context models support alphabets of up to " << RANS_CONTEXT_MAX_ALPHABET
+                  << " symbols and 1 to " << RANS_CONTEXT_MAX_BITS << " prob_bits, with every symbol getting a"
+                  << " frequency." << std::endl;
+        return out;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= alphabet) {
+            std::cout << "ERROR: Symbol " << i << " is outside of the alphabet." << std::endl;
+            return out;
+        }
+    }
+
+    out.resize(RANS_CONTEXT_HEADER_WORDS);
+    out[0] = RANS_FORMAT_MARKER(RANS_FORMAT_CONTEXT, order | (adaptive ? RANS_CONTEXT_ADAPTIVE : 0));
+    write_u64(&out[1], n);
+    out[3] = (uint32_t) alphabet;
+    out[4] = PROB_BITS;
+
+    std::unique_ptr<rANSContextModel> model;
+    if (adaptive) {
+        model.reset(new rANSContextModel(alphabet, order, PROB_BITS));
+        out.push_back(model->get_increment());
+        out.push_back(model->get_limit());
+        out.push_back(model->get_interval());
+    } else {
+        model.reset(new rANSContextModel(syms, n, alphabet, order, PROB_BITS));
+        model->write_tables(out);
+    }
+
+    // run the model forwards like the decoder will, keeping the range every symbol is coded with
+    std::vector<uint32_t> ranges(2*n);
+    uint64_t bits = 0;
+    uint32_t prev1 = 0, prev2 = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t ctx = model->context(prev1, prev2);
+        const uint32_t* cdf = model->get_cdf(ctx);
+        ranges[2*i] = cdf[syms[i]];
+        ranges[2*i+1] = cdf[syms[i]+1] - cdf[syms[i]];
+        bits += rANSSymbolCost(ranges[2*i+1], PROB_BITS);
+        model->update(ctx, syms[i]);
+        prev2 = prev1;
+        prev1 = syms[i];
+    }
+
+    out.reserve(out.size() + rANSCostWords(bits));
+
+    Rans64State context_state;
+    Rans64EncInit(&context_state);
+    for (size_t i = n; i-- > 0;) {
+        Rans64EncPut(&context_state, out, ranges[2*i], ranges[2*i+1], PROB_BITS);
+    }
+    Rans64EncFlush(&context_state, out);
+
+    return out;
+}
+
+size_t rANSCoder::num_context_symbols(const uint32_t* data, size_t size) {
+    if (size < RANS_CONTEXT_HEADER_WORDS || !RANS_FORMAT_IS(data[0], RANS_FORMAT_CONTEXT)) {
+        return 0;
+    }
+    return read_u64(data + 1);
+}
+
+void rANSCoder::decode_context(const uint32_t* data, size_t size, uint32_t* out) {
+    if (size < RANS_CONTEXT_HEADER_WORDS || !RANS_FORMAT_IS(data[0], RANS_FORMAT_CONTEXT)) {
+        std::cout << "ERROR: Not a context coded stream." << std::endl;
+        return;
+    }
+
+    uint32_t order = data[0] & ~RANS_CONTEXT_ADAPTIVE & 0xff;
+    bool adaptive = (data[0] & RANS_CONTEXT_ADAPTIVE) != 0;
+    size_t n = read_u64(data + 1);
+    size_t alphabet = data[3];
+    uint32_t prob_bits = data[4];
+    if (order < 1 || order > 2 || alphabet < 1 || alphabet > RANS_CONTEXT_MAX_ALPHABET || prob_bits < 1 ||
+        prob_bits > RANS_CONTEXT_MAX_BITS || alphabet > ((size_t) 1 << prob_bits)) {
+        std::cout << "ERROR: Unsupported context coded stream." << std::endl;
+        return;
+    }
+
+    size_t pos = RANS_CONTEXT_HEADER_WORDS;
+    std::unique_ptr<rANSContextModel> model;
+    if (adaptive) {
+        if (size - pos < RANS_CONTEXT_ADAPTIVE_WORDS) {
+            std::cout << "ERROR: Context coded stream is truncated." << std::endl;
+            return;
+        }
+        // only parameters the encoder can write, others would let the 16-bit counts wrap
+        uint32_t increment = data[pos], limit = data[pos+1], interval = data[pos+2];
+        if (increment < 1 || increment > RANS_CONTEXT_MAX_INCREMENT || limit > 0xffffu - increment || interval < 1) {
+            std::cout << "ERROR: Context coded stream has malformed model parameters." << std::endl;
+            return;
+        }
+        model.reset(new rANSContextModel(alphabet, order, prob_bits, increment, limit, interval));
+        pos += RANS_CONTEXT_ADAPTIVE_WORDS;
+    } else {
+        size_t used;
+        model.reset(new rANSContextModel(alphabet, order, prob_bits, data + pos, size - pos, &used));
+        if (!used) {
+            std::cout << "ERROR: Context coded stream has malformed tables." << std::endl;
+            return;
+        }
+        pos += used;
+    }
+
+    const uint32_t* begin = data + pos;
+    const uint32_t* ptr = data + size;
+    if (ptr - begin < 2) {
+        std::cout << "ERROR: Context coded stream is truncated." << std::endl;
+        return;
+    }
+
+    Rans64State context_state;
+    Rans64DecInitRev(&context_state, &ptr);
+    uint32_t prev1 = 0, prev2 = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t ctx = model->context(prev1, prev2);
+        uint32_t sym = model->find_symbol(ctx, Rans64DecGet(&context_state, prob_bits));
+        const uint32_t* cdf = model->get_cdf(ctx);
+        if (!Rans64DecAdvanceRevBounded(&context_state, &ptr, begin, cdf[sym], cdf[sym+1] - cdf[sym], prob_bits)) {
+            std::cout << "ERROR: Context coded stream ended before all symbols were decoded." << std::endl;
+            return;
+        }
+        model->update(ctx, sym);
+        out[i] = sym;
+        prev2 = prev1;
+        prev1 = sym;
+    }
+
+    if (ptr != begin) {
+        std::cout << "ERROR: Context coded stream is corrupt." << std::endl;
+    }
+}
+
+// Parameters read from the header of a stream produced by encode_static.
+typedef struct {
+    uint64_t n;
+    uint64_t prob_bits;
+    uint64_t alphabet;
+    std::vector<uint8_t> bytes;
+    size_t table;
+    size_t words;
+} rANSStaticHeader;
+
+// Reads the header of a stream produced by encode_static. Returns false if it is not one or it is malformed.
+static bool read_static_header(const uint32_t* data, size_t size, rANSStaticHeader& header) {
+    if (size < RANS_STATIC_HEADER_WORDS || data[0] != RANS_FORMAT_MARKER(RANS_FORMAT_STATIC, RANS_STATIC_VERSION) ||
+        data[1] > size - RANS_STATIC_HEADER_WORDS) {
+        return false;
+    }
+
+    header.words = RANS_STATIC_HEADER_WORDS + data[1];
+    header.bytes.resize((size_t) data[1] * 4);
+    for (size_t i = 0; i < header.bytes.size(); i++) {
+        header.bytes[i] = (uint8_t) (data[RANS_STATIC_HEADER_WORDS + i / 4] >> (8 * (i % 4)));
+    }
+
+    const uint8_t* ptr = header.bytes.data();
+    const uint8_t* end = ptr + header.bytes.size();
+    if (!rANSGetVarint(&ptr, end, &header.n) || !rANSGetVarint(&ptr, end, &header.prob_bits) ||
+        !rANSGetVarint(&ptr, end, &header.alphabet) || header.prob_bits < 1 ||
+        header.prob_bits > RANS_STATIC_MAX_BITS || header.alphabet < 1 ||
+        header.alphabet > RANS_STATIC_MAX_ALPHABET) {
+        return false;
+    }
+    header.table = ptr - header.bytes.data();
+    return true;
+}
+
+std::vector<uint32_t> rANSCoder::encode_static(const uint32_t* syms, size_t n, const rANSModel& model) {
+    std::vector<uint32_t> out;
+    if (!check_model(model)) return out;
+    if (model.size() < 1 || model.size() > RANS_STATIC_MAX_ALPHABET || PROB_BITS < 1 ||
+        PROB_BITS > RANS_STATIC_MAX_BITS) {
+        std::cout << "ERROR: Self-describing streams support alphabets of up to " << RANS_STATIC_MAX_ALPHABET
+                  << " symbols and up to " << RANS_STATIC_MAX_BITS << " prob_bits." << std::endl;
+        return out;
+    }
+    if (!check_symbols(syms, n, model)) return out;
+
+    std::vector<uint8_t> bytes;
+    rANSPutVarint(bytes, n);
+    rANSPutVarint(bytes, PROB_BITS);
+    rANSPutVarint(bytes, model.size());
+    model.write_table(bytes);
+
+    size_t header_words = (bytes.size() + 3) / 4;
+    out.reserve(RANS_STATIC_HEADER_WORDS + header_words + model.estimate_words(syms, n) + 1);
+    out.push_back(RANS_FORMAT_MARKER(RANS_FORMAT_STATIC, RANS_STATIC_VERSION));
+    out.push_back((uint32_t) header_words);
+    out.resize(RANS_STATIC_HEADER_WORDS + header_words, 0);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        out[RANS_STATIC_HEADER_WORDS + i / 4] |= (uint32_t) bytes[i] << (8 * (i % 4));
+    }
+
+    Rans64State static_state;
+    Rans64EncInit(&static_state);
+    for (size_t i = n; i > 0;) {
+        size_t stop = i > RANS_EC_CHUNK ? i - RANS_EC_CHUNK : 0;
+        size_t pos = out.size();
+        out.resize(pos + (i - stop));
+        uint32_t* ptr = out.data() + pos;
+        encode_model_run(&static_state, &ptr, syms + stop, i - stop, model);
+        out.resize(ptr - out.data());
+        i = stop;
+    }
+    Rans64EncFlush(&static_state, out);
+
+    return out;
+}
+
+std::vector<uint32_t> rANSCoder::encode_static(const uint32_t* syms, size_t n, size_t alphabet) {
+    std::vector<uint32_t> counts(alphabet);
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= alphabet) {
+            std::cout << "ERROR: Symbol " << i << " is outside of the alphabet." << std::endl;
+            return std::vector<uint32_t>();
+        }
+        counts[syms[i]]++;
+    }
+    if (n == 0 && alphabet > 0) counts[0] = 1;
+
+    // quantize the symbols that occur only, so that the table does not list the others
+    std::vector<uint32_t> used_counts;
+    for (size_t s = 0; s < alphabet; s++) {
+        if (counts[s]) used_counts.push_back(counts[s]);
+    }
+    if (used_counts.empty() || used_counts.size() > ((uint64_t) 1 << PROB_BITS)) {
+        std::cout << "ERROR: Self-describing streams need 1 to 2^prob_bits distinct symbols." << std::endl;
+        return std::vector<uint32_t>();
+    }
+    std::vector<uint32_t> used_freqs(used_counts.size());
+    std::vector<uint32_t> used_cdf(used_counts.size() + 1);
+    rANSQuantizeCounts(used_counts.data(), used_counts.size(), PROB_BITS, used_freqs.data(), used_cdf.data());
+
+    std::vector<uint32_t> freqs(alphabet, 0);
+    for (size_t s = 0, j = 0; s < alphabet; s++) {
+        if (counts[s]) freqs[s] = used_freqs[j++];
+    }
+    return encode_static(syms, n, rANSModel(freqs.data(), alphabet, PROB_BITS));
+}
+
+size_t rANSCoder::num_static_symbols(const uint32_t* data, size_t size) {
+    rANSStaticHeader header;
+    if (!read_static_header(data, size, header)) return 0;
+    return header.n;
+}
+
+void rANSCoder::decode_static(const uint32_t* data, size_t size, uint32_t* out) {
+    rANSStaticHeader header;
+    if (!read_static_header(data, size, header)) {
+        std::cout << "ERROR: Not a self-describing stream." << std::endl;
+        return;
+    }
+
+    size_t used;
+    rANSModel model(header.bytes.data() + header.table, header.bytes.size() - header.table, header.alphabet,
+                    header.prob_bits, &used);
+    if (!used) {
+        std::cout << "ERROR: Self-describing stream has a malformed table." << std::endl;
+        return;
+    }
+
+    const uint32_t* begin = data + header.words;
+    const uint32_t* ptr = data + size;
+    if (ptr - begin < 2) {
+        std::cout << "ERROR: Self-describing stream is truncated." << std::endl;
+        return;
+    }
+
+    Rans64State static_state;
+    Rans64DecInitRev(&static_state, &ptr);
+    size_t done = decode_model_run(&static_state, &ptr, begin, model, header.n, out);
+
+    if (done < header.n || ptr != begin) {
+        std::cout << "ERROR: Self-describing stream is corrupt." << std::endl;
+    }
+}
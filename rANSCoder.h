@@ -6,7 +6,20 @@
 #define CLIONSCRATCHPAD_RANSCODER_H
 
 #include "rans64_custom.hpp"
+#include "rANSModel.h"
+#include "rANSQuantize.h"
+#include "rANSAdaptiveModel.h"
+#include "rANSContextModel.h"
+#include "rANSParametricBank.h"
+#include "rANSTans.h"
+#include "rANSMappedFile.h"
+#include "rANSFormat.h"
+#include "rANSWide.h"
+#include "rANSThreadPool.h"
+#include "rANSStats.h"
 #include <vector>
+#include <cstddef>
+#include <memory>
 
 /**
  * @brief A rANS coder with a compression rate of an arithmetic coder, and the performance similar to Huffman coding.
@@ -41,10 +54,52 @@ private:
     uint32_t PROB_SCALE = 1 << PROB_BITS;
     uint32_t FLOATSHIFT = 1 << 11;
     uint32_t MIN_PROBABILITY = 1;
+    bool LEGACY_QUANTIZATION = true;
     std::vector<uint32_t> vec;
     bool flushed = false;
+    const uint32_t* dc_view = nullptr;
+    const uint32_t* dc_ptr = nullptr;
+    bool dc_error = false;
+    std::shared_ptr<rANSMappedFile> dc_map;
+    unsigned num_threads = 0;
+    std::shared_ptr<rANSThreadPool> pool;
+    // coding_cycles holds the whole time of the coding calls here, stats takes the quantization out
+    rANSStats counters = rANSStats();
+    // total of the pdf last quantized, for the ideal cost. Kept in every build, so that the layout of the coder does
+    // not depend on RANS_STATS.
+    double pdf_total = 0;
 
-    void convert_pdf(std::vector<float> orpdf, std::vector<uint32_t>& npdf, std::vector<uint32_t>& cdf);
+    void convert_pdf(const float* orpdf, size_t size, uint32_t* npdf, uint32_t* cdf) const;
+    void quantize_pdf(const float* orpdf, size_t size, uint32_t* npdf, uint32_t* cdf);
+    void count_call(uint64_t start, size_t words, size_t n);
+    void count_symbol(uint32_t freq);
+    void count_symbol(const float* pdf, uint32_t sym, uint32_t freq);
+    void count_symbols(const uint32_t* syms, size_t n, const uint32_t* freqs);
+    void count_escaped(const uint32_t* freqs, size_t n, size_t escapes);
+    bool check_model(const rANSModel& model) const;
+    bool check_symbols(const uint32_t* syms, size_t n, const rANSModel& model) const;
+    bool check_symbols(const uint32_t* syms, size_t n, size_t alphabet) const;
+    bool check_symbols(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet) const;
+    bool check_alphabet(size_t alphabet) const;
+    bool check_model(const rANSAdaptiveModel& model) const;
+    bool check_tans(const rANSTansTable& table) const;
+    bool check_bank(const uint32_t* scale_indices, size_t n, const rANSParametricBank& bank) const;
+    bool check_cdfs(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet) const;
+    const uint32_t* dc_cursor() const;
+    const uint32_t* dc_begin() const;
+    void dc_commit(const uint32_t* ptr);
+    uint32_t* ec_open(size_t room);
+    void ec_close(uint32_t* ptr);
+    rANSThreadPool& get_pool();
+
+    void encode_block(const uint32_t* syms, const float* pdfs, size_t alphabet, const rANSModel* model,
+                      size_t first, size_t last, std::vector<uint32_t>& out) const;
+    bool decode_block(const uint32_t* begin, const uint32_t* end, const float* pdfs, size_t alphabet,
+                      const rANSModel* model, size_t first, size_t last, uint32_t* out) const;
+    std::vector<uint32_t> encode_blocks_impl(const uint32_t* syms, const float* pdfs, size_t alphabet,
+                                             const rANSModel* model, size_t n, size_t block_size);
+    void decode_blocks_impl(const uint32_t* data, size_t size, const float* pdfs, size_t alphabet,
+                            const rANSModel* model, size_t range_begin, size_t range_end, uint32_t* out);
 
 public:
 
@@ -83,6 +138,10 @@ public:
      * from floating to integer point. The value floatshift lets you specify how many decimal places of a floating
      * point number are used to determine the corresponding probability bucket. Prob_bits describes the number of bits
      * used for the buckets, i.e. a value of 10 means that the buckets partition the integer values 0 to 1023.*
+     *
+     * Floatshift only applies to the legacy quantization, which is the default so that text encoded by earlier
+     * versions still decodes. See set_legacy_quantization to quantize in full precision with rANSQuantizePdf instead.
+     *
      * @param[in] floatshift A power of 2. Describes how many decimal positions are used to calculate the buckets.
      * @param[in] prob_bits The number of bits used to describe probabilities.
      *
@@ -131,6 +190,51 @@ public:
      */
     void init_dc(std::vector<uint32_t> data);
 
+    /**
+     * @brief Starts the rANSCoder as a decoder reading the encoded text in place.
+     *
+     * @details
+     *
+     * Unlike init_dc, the encoded text is not copied: the decoder reads it straight from the given memory, from
+     * the end towards the start. Use this for large payloads that already sit in memory owned by someone else, such
+     * as a NumPy array.
+     *
+     * @param[in] data A pointer describing the start of an array containing the encoded text.
+     * @param[in] size Size of the array.
+     *
+     * @attention The memory must stay valid and unchanged until decoding is done.
+     */
+    void init_dc_view(const uint32_t* data, size_t size);
+
+    /**
+     * @brief Starts the rANSCoder as a decoder reading the encoded text from a file, memory mapped.
+     *
+     * @details
+     *
+     * The file holds the words returned by get_buffer, as written in host byte order. It is decoded in place like with
+     * init_dc_view, without reading it first: only the pages the decoder touches are loaded, and they are shared with
+     * every other process mapping the file. The mapping is released by the next init_ec or init_dc.
+     *
+     * @param[in] path Path of the file.
+     * @return false if the file cannot be mapped or is too small, in which case the decoder is not started.
+     *
+     * @attention The file must not be modified while decoding.
+     */
+    bool init_dc_mmap(const char* path);
+
+    /**
+     * @brief Returns the number of words of the encoded buffer the decoder has not read yet.
+     *
+     * @details A buffer decoded with the right distributions and symbol count is read completely, leaving 0.
+     */
+    size_t words_left() const;
+
+    /**
+     * @brief Returns true if the buffer given to init_dc was too small, or a decode since ran out of words before
+     * all of its symbols.
+     */
+    bool decode_failed() const;
+
     /**
      * @brief Encodes a symbol.
      *
@@ -167,6 +271,95 @@ public:
      */
     void encode_sym(unsigned int sym, std::vector<float> pdf);
 
+    /**
+     * @brief Encodes a whole array of symbols in one call.
+     *
+     * @details
+     *
+     * This is equivalent to calling encode_sym for every symbol, but the whole loop runs in C++ and the buffers used
+     * to quantize the probability distributions are allocated only once. The symbols are pushed in reverse order,
+     * so that a subsequent decoding returns them in their original order instead of reversed.
+     *
+     * The probability distributions are given as a row-major matrix with n rows and alphabet columns, where row i is
+     * the distribution used for syms[i].
+     *
+     * Example usage:
+     *
+     *     rANSCoder encoder;
+     *     encoder.init_ec();
+     *     uint32_t syms[] = {1, 0, 2};
+     *     float pdfs[] = {0.25, 0.25, 0.5,
+     *                     0.25, 0.25, 0.5,
+     *                     0.5, 0.25, 0.25};
+     *     encoder.encode_batch(syms, pdfs, 3, 3);
+     *
+     *     auto encoded = encoder.get_buffer(); // Encoded text
+     *
+     * @param[in] syms Array of n symbols to encode, each below alphabet. Nothing is encoded otherwise.
+     * @param[in] pdfs Array of n*alphabet probabilities, one distribution per symbol.
+     * @param[in] n Number of symbols.
+     * @param[in] alphabet Size of the alphabet, i.e. the length of each distribution.
+     *
+     * @attention You must call init_ec before calling this method
+     */
+    void encode_batch(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet);
+
+    /**
+     * @brief Selects the quantization of probability distributions.
+     *
+     * @details The legacy quantization scales the probabilities by floatshift and rescales the integers, so small
+     * probabilities lose their resolution and can end up with a frequency of 0, which cannot be encoded. It is the
+     * default, because the coder's buffer does not record the quantization and text encoded by earlier versions has to
+     * keep decoding. Turn it off to quantize with rANSQuantizePdf, which uses all of the float precision and never
+     * gives a symbol a frequency of 0.
+     *
+     * Encoder and decoder must use the same setting. The setting applies to every pdf method of the coder, including
+     * encode_blocks and decode_blocks with pdfs.
+     *
+     * @param[in] legacy true to use the legacy quantization.
+     */
+    void set_legacy_quantization(bool legacy);
+
+    /**
+     * @brief Reserves room for the given number of encoded words.
+     *
+     * @details The batch encoders size the buffer from an estimate of the output themselves. Use this when the output
+     * size is known from elsewhere, or before many encode_sym calls, to avoid growing the buffer while encoding.
+     *
+     * @param[in] words Number of words to reserve on top of what is already encoded.
+     */
+    void reserve(size_t words);
+
+    /**
+     * @brief Encodes a symbol with a precomputed model.
+     *
+     * @details
+     *
+     * Same as encode_sym with a probability distribution, but the distribution is not quantized again and the
+     * symbol is pushed with the multiply-based encoder instead of a division. Use this whenever the distribution
+     * does not change between symbols. The output is identical to encoding with the pdf the model was built from.
+     *
+     * @param[in] sym Symbol to encode
+     * @param[in] model Model to encode with. Must use the same prob_bits as the coder.
+     *
+     * @attention You must call init_ec before calling this method
+     */
+    void encode_sym(unsigned int sym, const rANSModel& model);
+
+    /**
+     * @brief Encodes a whole array of symbols with a precomputed model.
+     *
+     * @details Like encode_batch with a pdf matrix, symbols are decoded in their original order. Nothing is encoded if a
+     * symbol is outside of the model's alphabet or has a frequency of 0.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in] model Model to encode with. Must use the same prob_bits as the coder.
+     *
+     * @attention You must call init_ec before calling this method
+     */
+    void encode_batch(const uint32_t* syms, size_t n, const rANSModel& model);
+
     /**
      * @brief Decodes a symbol.
      *
@@ -204,6 +397,279 @@ public:
      */
     uint32_t decode_sym(std::vector<float> pdf);
 
+    /**
+     * @brief Decodes a whole array of symbols in one call.
+     *
+     * @details
+     *
+     * This is the counterpart of encode_batch. Symbols are written to out in the order they were passed to
+     * encode_batch, so no reversal is necessary afterwards. The probability distributions are given as a row-major
+     * matrix with n rows and alphabet columns, and must correspond exactly to the ones used to encode.
+     *
+     * Example usage, decoding the output of the encode_batch example:
+     *
+     *     rANSCoder decoder;
+     *     decoder.init_dc(encoded);
+     *     uint32_t syms[3];
+     *     decoder.decode_batch(pdfs, 3, 3, syms); // syms = {1, 0, 2}
+     *
+     * @param[in] pdfs Array of n*alphabet probabilities, one distribution per symbol.
+     * @param[in] n Number of symbols to decode.
+     * @param[in] alphabet Size of the alphabet, i.e. the length of each distribution.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    void decode_batch(const float* pdfs, size_t n, size_t alphabet, uint32_t* out);
+
+    /**
+     * @brief Decodes a symbol with a precomputed model.
+     *
+     * @param[in] model Model to decode with - must correspond exactly to the distribution used to encode.
+     * @return A decoded symbol.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    uint32_t decode_sym(const rANSModel& model);
+
+    /**
+     * @brief Encodes an array of symbols with several interleaved rANS states.
+     *
+     * @details
+     *
+     * With a single state, every encoding step has to wait for the result of the previous one. Here, symbol i is
+     * coded with state i % ways, so consecutive symbols are independent and the CPU can work on several of them at
+     * once. All states write into the same buffer, which is returned as a self-contained stream: it starts with a
+     * marker word recording the format and the number of states, and is independent of the coder's own buffer.
+     *
+     * Example usage:
+     *
+     *     rANSModel model(probs);
+     *     rANSCoder coder;
+     *     auto encoded = coder.encode_interleaved(syms, n, model, 4);
+     *     coder.decode_interleaved(encoded.data(), encoded.size(), model, n, out);
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in] model Model to encode with. Must use the same prob_bits as the coder.
+     * @param[in] ways Number of interleaved states, 1, 2, 4 or 8.
+     * @return The encoded stream.
+     */
+    std::vector<uint32_t> encode_interleaved(const uint32_t* syms, size_t n, const rANSModel& model, uint32_t ways = 4);
+
+    /**
+     * @brief Decodes a stream produced by encode_interleaved.
+     *
+     * @details The number of states is read from the stream. Symbols are written to out in their original order.
+     * The stream is decoded in place and does not change the state of the coder. Streams produced by encode_wide
+     * are recognized and decoded as well.
+     *
+     * @param[in] data The encoded stream.
+     * @param[in] size Size of the stream in words.
+     * @param[in] model Model to decode with - must correspond exactly to the distribution used to encode.
+     * @param[in] n Number of symbols to decode.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text.
+     */
+    void decode_interleaved(const uint32_t* data, size_t size, const rANSModel& model, size_t n, uint32_t* out);
+
+    /**
+     * @brief Encodes an array of symbols for the vectorized decoder.
+     *
+     * @details
+     *
+     * Like encode_interleaved, but with 8 or 16 lanes of 32-bit states renormalizing by 16 bits. When the library is
+     * built for AVX2 (8 lanes) or AVX-512 (16 lanes), all lanes are decoded at once in vector registers, with the
+     * symbol lookup done by gathers into the model's lookup table. The compression rate is the same as with the
+     * other coding methods, up to a few bytes of header.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in] model Model to encode with. Must use the same prob_bits as the coder, at most 16.
+     * @param[in] lanes Number of lanes, 8 or 16.
+     * @return The encoded stream.
+     */
+    std::vector<uint32_t> encode_wide(const uint32_t* syms, size_t n, const rANSModel& model, uint32_t lanes = 8);
+
+    /**
+     * @brief Decodes a stream produced by encode_wide.
+     *
+     * @param[in] data The encoded stream.
+     * @param[in] size Size of the stream in words.
+     * @param[in] model Model to decode with - must correspond exactly to the distribution used to encode.
+     * @param[in] n Number of symbols to decode.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+     */
+    void decode_wide(const uint32_t* data, size_t size, const rANSModel& model, size_t n, uint32_t* out);
+
+    /**
+     * @brief Encodes an array of symbols with the tANS backend and returns a self-contained stream.
+     *
+     * @details The tANS decoder needs a table lookup and a bit read per symbol instead of the multiplication of rANS,
+     * which tends to pay off for small alphabets. See rANSTansTable for the coder and rANSTansEncode for the stream
+     * layout. Does not touch the coder's own buffer.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in] table Table built from a model with the same prob_bits as the coder, RANS_TANS_MIN_BITS to
+     * RANS_TANS_MAX_BITS.
+     * @return The encoded stream, empty on error.
+     */
+    std::vector<uint32_t> encode_tans(const uint32_t* syms, size_t n, const rANSTansTable& table);
+
+    /**
+     * @brief Decodes a stream produced by encode_tans.
+     *
+     * @param[in] data The encoded stream.
+     * @param[in] size Size of the stream in words.
+     * @param[in] table Table to decode with - must be built from the model used to encode.
+     * @param[in] n Number of symbols to decode.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+     */
+    void decode_tans(const uint32_t* data, size_t size, const rANSTansTable& table, size_t n, uint32_t* out);
+
+    /**
+     * @brief Decodes a whole array of symbols with a precomputed model.
+     *
+     * @details Like every decode method, it never reads before the start of the encoded buffer. Asking for more
+     * symbols than the buffer holds prints an error once the words run out and leaves the remaining symbols 0.
+     *
+     * @param[in] model Model to decode with - must correspond exactly to the distribution used to encode.
+     * @param[in] n Number of symbols to decode.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    void decode_batch(const rANSModel& model, size_t n, uint32_t* out);
+
+    /**
+     * @brief Encodes a whole array of symbols with an adaptive model.
+     *
+     * @details
+     *
+     * The model learns every symbol in original order, as the decoder will, and the symbols are then encoded
+     * backwards, so that decoding returns them in their original order. There is no encode_sym for adaptive models,
+     * since symbols pushed one by one decode in reverse and the models would not see the same sequence.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in,out] model Model to encode with, it learns the symbols. Must use the same prob_bits as the coder.
+     *
+     * @attention You must call init_ec before calling this method
+     */
+    void encode_batch(const uint32_t* syms, size_t n, rANSAdaptiveModel& model);
+
+    /**
+     * @brief Decodes a symbol with an adaptive model, which then learns it.
+     *
+     * @param[in,out] model Model to decode with - must be in the state the encoder's model was in at this symbol.
+     * @return A decoded symbol.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    uint32_t decode_sym(rANSAdaptiveModel& model);
+
+    /**
+     * @brief Decodes a whole array of symbols with an adaptive model.
+     *
+     * @param[in,out] model Model to decode with - must start in the state the encoder's model started in.
+     * @param[in] n Number of symbols to decode.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    void decode_batch(rANSAdaptiveModel& model, size_t n, uint32_t* out);
+
+    /**
+     * @brief Encodes a symbol with an already quantized integer cdf.
+     *
+     * @details
+     *
+     * Use this when the distribution is already available as integers, like the cdf tables of learned compression
+     * models. There is no float conversion, no quantization and no allocation, the symbol is pushed with
+     * cdf[sym] and cdf[sym+1] directly.
+     *
+     * @param[in] sym Symbol to encode, below alphabet and with cdf[sym+1] larger than cdf[sym].
+     * @param[in] cdf Cumulative frequencies, alphabet+1 entries starting with 0 and ending with 2 to the power of
+     * prob_bits.
+     * @param[in] alphabet Size of the alphabet.
+     *
+     * @attention You must call init_ec before calling this method
+     */
+    void encode_sym_cdf(unsigned int sym, const uint32_t* cdf, size_t alphabet);
+
+    /**
+     * @brief Encodes a whole array of symbols with one integer cdf per symbol.
+     *
+     * @details Same as calling encode_sym_cdf for every symbol, backwards, so that decoding returns the symbols in
+     * their original order. All cdfs are checked before encoding, nothing is encoded if one does not end with 2 to
+     * the power of prob_bits or gives its symbol a frequency of 0.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] cdfs Array of n*(alphabet+1) cumulative frequencies, one cdf per symbol.
+     * @param[in] n Number of symbols.
+     * @param[in] alphabet Size of the alphabet, each cdf has alphabet+1 entries.
+     *
+     * @attention You must call init_ec before calling this method
+     */
+    void encode_batch_cdf(const uint32_t* syms, const uint32_t* cdfs, size_t n, size_t alphabet);
+
+    /**
+     * @brief Decodes a symbol with an already quantized integer cdf.
+     *
+     * @param[in] cdf Cumulative frequencies, alphabet+1 entries - must be the cdf used to encode.
+     * @param[in] alphabet Size of the alphabet.
+     * @return The decoded symbol, 0 if the cdf does not end with 2 to the power of prob_bits.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    uint32_t decode_sym_cdf(const uint32_t* cdf, size_t alphabet);
+
+    /**
+     * @brief Decodes a whole array of symbols with one integer cdf per symbol.
+     *
+     * @param[in] cdfs Array of n*(alphabet+1) cumulative frequencies - must be the cdfs used to encode.
+     * @param[in] n Number of symbols to decode.
+     * @param[in] alphabet Size of the alphabet, each cdf has alphabet+1 entries.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    void decode_batch_cdf(const uint32_t* cdfs, size_t n, size_t alphabet, uint32_t* out);
+
+    /**
+     * @brief Encodes a whole array of signed symbols with a bank of parametric distributions.
+     *
+     * @details
+     *
+     * Symbol i is coded as its residual to round(means[i]) with the table of scale index scale_indices[i], which
+     * costs a table lookup instead of building and quantizing a pdf. Residuals outside the table are escaped and
+     * written in raw bits, see rANSParametricBank.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] means Array of n predicted means. Non-finite means count as 0.
+     * @param[in] scale_indices Array of n indices into the bank, e.g. from rANSParametricBank::scale_indices.
+     * @param[in] n Number of symbols.
+     * @param[in] bank Bank to encode with. Must use the same prob_bits as the coder.
+     *
+     * @attention You must call init_ec before calling this method
+     */
+    void encode_batch_parametric(const int32_t* syms, const float* means, const uint32_t* scale_indices, size_t n,
+                                 const rANSParametricBank& bank);
+
+    /**
+     * @brief Decodes a whole array of symbols encoded with encode_batch_parametric.
+     *
+     * @param[in] means Array of n predicted means - must be the means used to encode.
+     * @param[in] scale_indices Array of n indices into the bank - must be the indices used to encode.
+     * @param[in] n Number of symbols to decode.
+     * @param[in] bank Bank to decode with - must be built with the same parameters as the one used to encode.
+     * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+     *
+     * @attention You must call init_dc before calling this method
+     */
+    void decode_batch_parametric(const float* means, const uint32_t* scale_indices, size_t n,
+                                 const rANSParametricBank& bank, int32_t* out);
+
     /**
      * @brief Returns an array containing the previously encoded data.
      *
@@ -271,6 +737,250 @@ public:
      */
     std::vector<uint32_t> get_buffer();
 
+    /**
+     * @brief Returns the previously encoded data, handing over the coder's buffer.
+     *
+     * @details Same as get_buffer, but the buffer is moved out instead of copied, and the coder starts over with an
+     * empty buffer. Use this to avoid a copy of large outputs.
+     *
+     * @return The encoded data as a vector.
+     *
+     * @attention You must call init_ec before calling this method.
+     */
+    std::vector<uint32_t> release_buffer();
+
+    /**
+     * @brief Sets the number of threads used by the block-parallel methods.
+     *
+     * @param[in] threads Number of threads, including the calling one. 0, the default, means one per core.
+     */
+    void set_num_threads(unsigned threads);
+
+    /**
+     * @brief Returns the counters of everything coded since construction or the last reset_stats.
+     *
+     * @details Counts the symbols coded into and out of the coder's own buffer: encode_sym, encode_batch,
+     * encode_batch_cdf, encode_batch_parametric and their decoding counterparts. The self-contained streams
+     * (interleaved, wide, tANS, blocks, context and static) are not counted, their size is known from the stream.
+     *
+     * The counting, a log2 and two time stamps per call or symbol, is only compiled in when the library is built with
+     * RANS_STATS defined (the CMake option RANS_STATS). Otherwise all counters stay 0 and the coding paths are
+     * unchanged.
+     *
+     * @return The counters, see rANSStats.
+     */
+    rANSStats stats() const;
+
+    /**
+     * @brief Sets all counters returned by stats to 0.
+     */
+    void reset_stats();
+
+    /**
+     * @brief Encodes an array of symbols as independently coded blocks, in parallel.
+     *
+     * @details
+     *
+     * The symbols are split into blocks of block_size symbols. Every block is coded with its own rANS state on the
+     * coder's thread pool (see set_num_threads), and the blocks are collected into one self-contained container:
+     *
+     *     marker word (RANS_FORMAT_BLOCKS, version)
+     *     number of symbols (two words, low word first)
+     *     block_size
+     *     number of blocks
+     *     block index, per block: word offset into the payload (two words) and size in words
+     *     payload, the blocks one after the other
+     *
+     * Each block costs two words for its final state plus three index words, so blocks should hold at least a few
+     * thousand symbols. The coder's own buffer is not touched.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] pdfs Array of n*alphabet probabilities, one distribution per symbol.
+     * @param[in] n Number of symbols.
+     * @param[in] alphabet Size of the alphabet, i.e. the length of each distribution.
+     * @param[in] block_size Number of symbols per block.
+     * @return The encoded container.
+     */
+    std::vector<uint32_t> encode_blocks(const uint32_t* syms, const float* pdfs, size_t n, size_t alphabet,
+                                        size_t block_size = 1 << 16);
+
+    /**
+     * @brief Encodes an array of symbols with a precomputed model as independently coded blocks, in parallel.
+     *
+     * @details Same container as encode_blocks with a pdf matrix.
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in] model Model to encode with. Must use the same prob_bits as the coder.
+     * @param[in] block_size Number of symbols per block.
+     * @return The encoded container.
+     */
+    std::vector<uint32_t> encode_blocks(const uint32_t* syms, size_t n, const rANSModel& model,
+                                        size_t block_size = 1 << 16);
+
+    /**
+     * @brief Decodes a container produced by encode_blocks, in parallel.
+     *
+     * @param[in] data The encoded container.
+     * @param[in] size Size of the container in words.
+     * @param[in] pdfs Array of n*alphabet probabilities, must be the ones used to encode.
+     * @param[in] alphabet Size of the alphabet.
+     * @param[out] out Preallocated array of n symbols, see num_block_symbols, receiving the decoded text.
+     */
+    void decode_blocks(const uint32_t* data, size_t size, const float* pdfs, size_t alphabet, uint32_t* out);
+
+    /**
+     * @brief Decodes a container produced by encode_blocks with a model, in parallel.
+     *
+     * @param[in] data The encoded container.
+     * @param[in] size Size of the container in words.
+     * @param[in] model Model to decode with - must correspond exactly to the distribution used to encode.
+     * @param[out] out Preallocated array of n symbols, see num_block_symbols, receiving the decoded text.
+     */
+    void decode_blocks(const uint32_t* data, size_t size, const rANSModel& model, uint32_t* out);
+
+    /**
+     * @brief Returns the number of symbols stored in a container produced by encode_blocks, or 0 if it is malformed.
+     */
+    static size_t num_block_symbols(const uint32_t* data, size_t size);
+
+    /**
+     * @brief Decodes the symbols [begin, end) of a container produced by encode_blocks.
+     *
+     * @details
+     *
+     * Block b of the container holds the symbols [b*block_size, (b+1)*block_size), and the index gives the position
+     * of every block in the payload. So only the blocks overlapping the requested range are located and decoded,
+     * in parallel, instead of the whole container. Use this to fetch, for example, a single tile of an image.
+     *
+     * Example usage:
+     *
+     *     auto encoded = coder.encode_blocks(syms, n, model, 4096);
+     *     std::vector<uint32_t> tile(1000);
+     *     coder.decode_range(encoded.data(), encoded.size(), model, 50000, 51000, tile.data());
+     *
+     * @param[in] data The encoded container.
+     * @param[in] size Size of the container in words.
+     * @param[in] pdfs Array of n*alphabet probabilities for the whole container, row i belonging to symbol i. Only
+     * the rows of the decoded blocks are read.
+     * @param[in] alphabet Size of the alphabet.
+     * @param[in] begin Index of the first symbol to decode.
+     * @param[in] end Index one past the last symbol to decode. Clamped to the number of symbols.
+     * @param[out] out Preallocated array of end-begin symbols.
+     */
+    void decode_range(const uint32_t* data, size_t size, const float* pdfs, size_t alphabet,
+                      size_t begin, size_t end, uint32_t* out);
+
+    /**
+     * @brief Decodes the symbols [begin, end) of a container produced by encode_blocks with a model.
+     *
+     * @param[in] data The encoded container.
+     * @param[in] size Size of the container in words.
+     * @param[in] model Model to decode with - must correspond exactly to the distribution used to encode.
+     * @param[in] begin Index of the first symbol to decode.
+     * @param[in] end Index one past the last symbol to decode. Clamped to the number of symbols.
+     * @param[out] out Preallocated array of end-begin symbols.
+     */
+    void decode_range(const uint32_t* data, size_t size, const rANSModel& model,
+                      size_t begin, size_t end, uint32_t* out);
+
+    /**
+     * @brief Encodes an array of symbols with an order-1 or order-2 context model.
+     *
+     * @details
+     *
+     * Every symbol is coded with the distribution of the symbols that followed the same previous one (order 1) or
+     * two (order 2) symbols, see rANSContextModel. For byte-like data this captures a lot more than one distribution
+     * for all symbols.
+     *
+     * A static model is built from the symbols in a first pass and stored in the stream. An adaptive model learns
+     * while coding and only stores its parameters, which pays off for short texts or drifting statistics. Either way
+     * the result is a self-contained stream that does not touch the coder's own buffer:
+     *
+     *     marker word (RANS_FORMAT_CONTEXT, order | RANS_CONTEXT_ADAPTIVE if adaptive)
+     *     number of symbols (2 words), alphabet, prob_bits
+     *     adaptive: increment, limit, interval; static: the tables, see rANSContextModel::write_tables
+     *     payload
+     *
+     * @param[in] syms Array of n symbols to encode.
+     * @param[in] n Number of symbols.
+     * @param[in] alphabet Size of the alphabet, at most RANS_CONTEXT_MAX_ALPHABET.
+     * @param[in] order 1 or 2.
+     * @param[in] adaptive true for an adaptive model, false for a static one.
+     * @return The encoded stream, empty on error. prob_bits must be at most RANS_CONTEXT_MAX_BITS.
+     */
+    std::vector<uint32_t> encode_context(const uint32_t* syms, size_t n, size_t alphabet, uint32_t order,
+                                         bool adaptive = false);
+
+    /**
+     * @brief Returns the number of symbols in a stream produced by encode_context, or 0 if it is not one.
+     */
+    static size_t num_context_symbols(const uint32_t* data, size_t size);
+
+    /**
+     * @brief Decodes a stream produced by encode_context.
+     *
+     * @details The model and its parameters are read from the stream, the coder's prob_bits are not used.
+     *
+     * @param[in] data The encoded stream.
+     * @param[in] size Size of the stream in words.
+     * @param[out] out Preallocated array of num_context_symbols symbols receiving the decoded text in original order.
+     */
+    void decode_context(const uint32_t* data, size_t size, uint32_t* out);
+
+    /**
+     * @brief Encodes an array of symbols with a static model into a stream that describes itself.
+     *
+     * @details
+     *
+     * The stream carries everything the decoder needs: the number of symbols, prob_bits, the alphabet size and the
+     * quantized frequencies of the model, so nothing has to travel out of band. The header is made of varints packed
+     * into bytes and the table is delta coded, see rANSModel::write_table, which keeps it at tens of bytes for small
+     * blocks that use few symbols:
+     *
+     *     marker word (RANS_FORMAT_STATIC, version)
+     *     number of header words
+     *     header bytes, zero padded to whole words: varints number of symbols, prob_bits, alphabet, then the table
+     *     payload
+     *
+     * Bytes are packed from the least significant byte of each word on. The coder's own buffer is not touched.
+     *
+     * @param[in] syms Array of n symbols to encode, all with a frequency above 0 in the model.
+     * @param[in] n Number of symbols.
+     * @param[in] model Model to encode with. Must use the same prob_bits as the coder.
+     * @return The encoded stream, empty on error.
+     */
+    std::vector<uint32_t> encode_static(const uint32_t* syms, size_t n, const rANSModel& model);
+
+    /**
+     * @brief Encodes an array of symbols into a self-describing stream, with a model built from their counts.
+     *
+     * @details Same stream as encode_static with a model, which is built from the counts of the symbols with
+     * rANSQuantizeCounts. Only the symbols that occur get a frequency, so the table stays small for short texts.
+     *
+     * @param[in] syms Array of n symbols to encode, all below alphabet.
+     * @param[in] n Number of symbols.
+     * @param[in] alphabet Size of the alphabet.
+     * @return The encoded stream, empty on error.
+     */
+    std::vector<uint32_t> encode_static(const uint32_t* syms, size_t n, size_t alphabet);
+
+    /**
+     * @brief Returns the number of symbols in a stream produced by encode_static, or 0 if it is not one.
+     */
+    static size_t num_static_symbols(const uint32_t* data, size_t size);
+
+    /**
+     * @brief Decodes a stream produced by encode_static.
+     *
+     * @details The model is read from the stream, the coder's prob_bits are not used.
+     *
+     * @param[in] data The encoded stream.
+     * @param[in] size Size of the stream in words.
+     * @param[out] out Preallocated array of num_static_symbols symbols receiving the decoded text in original order.
+     */
+    void decode_static(const uint32_t* data, size_t size, uint32_t* out);
+
 };
 
 
@@ -0,0 +1,172 @@
+//
+// Order-1 and order-2 context models for the rANSCoder.
+//
+
+#include "rANSContextModel.h"
+#include <algorithm>
+#include <iostream>
+
+rANSContextModel::rANSContextModel(size_t alphabet, uint32_t order, uint32_t prob_bits, uint32_t increment,
+                                   uint32_t limit, uint32_t interval)
+    : alphabet(alphabet), order(order), prob_bits(prob_bits), adaptive(true),
+      increment(std::min(std::max(increment, 1u), (uint32_t) RANS_CONTEXT_MAX_INCREMENT)),
+      limit(std::min(limit, 0xffffu - this->increment)), interval(std::max(interval, 1u)) {
+
+    if (!init()) return;
+    counts.assign(num_contexts * alphabet, 1);
+    totals.assign(num_contexts, (uint32_t) alphabet);
+    seen.assign(num_contexts, 0);
+}
+
+rANSContextModel::rANSContextModel(const uint32_t* syms, size_t n, size_t alphabet, uint32_t order,
+                                   uint32_t prob_bits)
+    : alphabet(alphabet), order(order), prob_bits(prob_bits), adaptive(false), increment(0), limit(0), interval(0) {
+
+    if (!init()) return;
+
+    std::vector<uint32_t> stats(num_contexts * alphabet);
+    uint32_t prev1 = 0, prev2 = 0;
+    for (size_t i = 0; i<n; i++) {
+        stats[context(prev1, prev2) * alphabet + syms[i]]++;
+        prev2 = prev1;
+        prev1 = syms[i];
+    }
+
+    for (size_t ctx = 0; ctx<num_contexts; ctx++) {
+        set_context(ctx, stats.data() + ctx * alphabet);
+    }
+}
+
+rANSContextModel::rANSContextModel(size_t alphabet, uint32_t order, uint32_t prob_bits, const uint32_t* tables,
+                                   size_t size, size_t* used)
+    : alphabet(alphabet), order(order), prob_bits(prob_bits), adaptive(false), increment(0), limit(0), interval(0) {
+
+    *used = 0;
+    if (!init()) return;
+
+    std::vector<uint32_t> ctx_counts(alphabet);
+    if (size < 1) return;
+    size_t pos = 1;
+    for (uint32_t c = 0; c < tables[0]; c++) {
+        if (size - pos < 2 || tables[pos] >= num_contexts || occurs[tables[pos]] || tables[pos + 1] > alphabet) return;
+        size_t ctx = tables[pos];
+        size_t m = tables[pos + 1];
+        pos += 2;
+        if (size - pos < m) return;
+
+        // the frequencies are stored quantized, so the counts are the frequencies themselves
+        std::fill(ctx_counts.begin(), ctx_counts.end(), 0);
+        uint64_t sum = 0;
+        for (size_t j = 0; j<m; j++) {
+            uint32_t sym = tables[pos + j] >> 16;
+            if (sym >= alphabet || ctx_counts[sym]) return;
+            ctx_counts[sym] = (tables[pos + j] & 0xffff) + 1;
+            sum += ctx_counts[sym];
+        }
+        if (sum != ((uint64_t) 1 << prob_bits)) return;
+        pos += m;
+
+        occurs[ctx] = 1;
+        uint32_t* cdf = cdfs.data() + ctx * (alphabet + 1);
+        cdf[0] = 0;
+        for (size_t s = 0; s<alphabet; s++) {
+            cdf[s + 1] = cdf[s] + ctx_counts[s];
+        }
+    }
+
+    *used = pos;
+}
+
+bool rANSContextModel::init() {
+    reduced = 1;
+    num_contexts = 0;
+    if (alphabet < 1 || alphabet > RANS_CONTEXT_MAX_ALPHABET || prob_bits < 1 || prob_bits > RANS_CONTEXT_MAX_BITS ||
+        alphabet > ((size_t) 1 << prob_bits)) {
+        std::cout << "ERROR: Context models need 1 to " << RANS_CONTEXT_MAX_ALPHABET << " symbols, at most 2^prob_bits"
+                  << ", and 1 to " << RANS_CONTEXT_MAX_BITS << " prob_bits." << std::endl;
+        alphabet = 0;
+        return false;
+    }
+
+    if (order == 2) {
+        reduced = std::max<size_t>(1, std::min<size_t>(alphabet, RANS_CONTEXT_MAX_CONTEXTS / alphabet));
+    }
+    num_contexts = alphabet * reduced;
+    occurs.assign(num_contexts, 0);
+
+    // all contexts start out uniform
+    cdfs.resize(num_contexts * (alphabet + 1));
+    std::vector<uint32_t> freqs(alphabet);
+    std::vector<uint32_t> zeros(alphabet);
+    rANSQuantizeCounts(zeros.data(), alphabet, prob_bits, freqs.data(), cdfs.data());
+    for (size_t ctx = 1; ctx<num_contexts; ctx++) {
+        std::copy(cdfs.begin(), cdfs.begin() + alphabet + 1, cdfs.begin() + ctx * (alphabet + 1));
+    }
+    return true;
+}
+
+void rANSContextModel::set_context(size_t ctx, const uint32_t* ctx_counts) {
+    std::vector<uint32_t> dense;
+    std::vector<uint32_t> syms;
+    for (size_t s = 0; s<alphabet; s++) {
+        if (ctx_counts[s]) {
+            dense.push_back(ctx_counts[s]);
+            syms.push_back((uint32_t) s);
+        }
+    }
+    if (dense.empty()) return;
+    occurs[ctx] = 1;
+
+    // only the symbols that occur get a frequency
+    std::vector<uint32_t> freqs(dense.size());
+    std::vector<uint32_t> dense_cdf(dense.size() + 1);
+    rANSQuantizeCounts(dense.data(), dense.size(), prob_bits, freqs.data(), dense_cdf.data());
+
+    uint32_t* cdf = cdfs.data() + ctx * (alphabet + 1);
+    std::fill(cdf, cdf + alphabet + 1, 0);
+    for (size_t j = 0; j<syms.size(); j++) {
+        cdf[syms[j] + 1] = freqs[j];
+    }
+    for (size_t s = 0; s<alphabet; s++) {
+        cdf[s + 1] += cdf[s];
+    }
+}
+
+void rANSContextModel::write_tables(std::vector<uint32_t>& out) const {
+    size_t count_pos = out.size();
+    out.push_back(0);
+
+    for (size_t ctx = 0; ctx<num_contexts; ctx++) {
+        if (!occurs[ctx]) continue;
+        const uint32_t* cdf = get_cdf(ctx);
+
+        out.push_back((uint32_t) ctx);
+        size_t m_pos = out.size();
+        out.push_back(0);
+        for (size_t s = 0; s<alphabet; s++) {
+            uint32_t freq = cdf[s + 1] - cdf[s];
+            if (freq) out.push_back((uint32_t) s << 16 | (freq - 1));
+        }
+        out[m_pos] = (uint32_t) (out.size() - m_pos - 1);
+        out[count_pos]++;
+    }
+}
+
+void rANSContextModel::rescale(size_t ctx) {
+    uint16_t* c = counts.data() + ctx * alphabet;
+    uint32_t total = 0;
+    for (size_t s = 0; s<alphabet; s++) {
+        c[s] = (uint16_t) ((c[s] + 1) / 2);
+        total += c[s];
+    }
+    totals[ctx] = total;
+}
+
+void rANSContextModel::rebuild(size_t ctx) {
+    static thread_local std::vector<uint32_t> ctx_counts;
+    static thread_local std::vector<uint32_t> freqs;
+
+    ctx_counts.assign(counts.begin() + ctx * alphabet, counts.begin() + (ctx + 1) * alphabet);
+    freqs.resize(alphabet);
+    rANSQuantizeCounts(ctx_counts.data(), alphabet, prob_bits, freqs.data(), cdfs.data() + ctx * (alphabet + 1));
+}
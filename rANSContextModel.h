@@ -0,0 +1,151 @@
+//
+// Order-1 and order-2 context models for the rANSCoder.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSCONTEXTMODEL_H
+#define CLIONSCRATCHPAD_RANSCONTEXTMODEL_H
+
+#include "rANSSearch.h"
+#include "rANSQuantize.h"
+#include <vector>
+#include <cstddef>
+
+// Largest number of contexts of an order-2 model. The second previous symbol is reduced to its most significant part
+// so that alphabet * reduced stays below this, for bytes that is the upper 4 bits.
+#define RANS_CONTEXT_MAX_CONTEXTS (1 << 12)
+
+// Largest alphabet of context models, the tables of an order-1 model grow with its square.
+#define RANS_CONTEXT_MAX_ALPHABET 1024
+
+// Largest prob_bits of context models, frequencies are stored in 16 bits.
+#define RANS_CONTEXT_MAX_BITS 16
+
+// Largest increment of adaptive context models, whose counts are 16 bits.
+#define RANS_CONTEXT_MAX_INCREMENT (1 << 15)
+
+/**
+ * @brief A table of frequency models selected by the previous one or two symbols.
+ *
+ * @details All contexts share one contiguous array of cdfs, alphabet+1 entries per context, so the tables of an
+ * order-1 model over bytes take 257 KiB and stay in the L2 cache. Symbols before the start of the stream count as 0.
+ *
+ * A static model is built from the text itself in a first pass. It gives frequencies only to symbols that occur in
+ * a context, and its tables travel with the encoded text, see write_tables. Contexts that do not occur stay uniform.
+ * An adaptive model starts uniform in every context and learns like rANSAdaptiveModel, with 16-bit counts per
+ * context; only its parameters travel with the text.
+ *
+ * @attention The alphabet must hold 1 to RANS_CONTEXT_MAX_ALPHABET symbols and at most 2 to the power of prob_bits, so
+ * that every symbol can get a frequency. Otherwise the model is left empty, with a size of 0, and must not be used.
+ */
+class rANSContextModel {
+
+private:
+
+    size_t alphabet;
+    uint32_t order;
+    uint32_t prob_bits;
+    size_t reduced;
+    size_t num_contexts;
+    bool adaptive;
+    uint32_t increment;
+    uint32_t limit;
+    uint32_t interval;
+    std::vector<uint32_t> cdfs;
+    std::vector<uint16_t> counts;
+    std::vector<uint32_t> totals;
+    std::vector<uint32_t> seen;
+    std::vector<uint8_t> occurs;
+
+    bool init();
+    void set_context(size_t ctx, const uint32_t* ctx_counts);
+    void rescale(size_t ctx);
+    void rebuild(size_t ctx);
+
+public:
+
+    /**
+     * @brief Builds an adaptive model, uniform in every context.
+     *
+     * @param[in] alphabet Size of the alphabet, at most 2 to the power of prob_bits.
+     * @param[in] order 1 or 2.
+     * @param[in] prob_bits The number of bits used to describe probabilities, at most RANS_CONTEXT_MAX_BITS.
+     * @param[in] increment Amount added to the count of a symbol in its context after it is coded, 1 to
+     * RANS_CONTEXT_MAX_INCREMENT.
+     * @param[in] limit The counts of a context are halved when their sum exceeds this, at most 65535 - increment.
+     * @param[in] interval Number of symbols of a context between rebuilds of its table.
+     */
+    rANSContextModel(size_t alphabet, uint32_t order, uint32_t prob_bits = 14, uint32_t increment = 24,
+                     uint32_t limit = 1 << 13, uint32_t interval = 256);
+
+    /**
+     * @brief Builds a static model from the statistics of a text.
+     *
+     * @param[in] syms Array of n symbols, all below alphabet.
+     * @param[in] n Number of symbols.
+     * @param[in] alphabet Size of the alphabet.
+     * @param[in] order 1 or 2.
+     * @param[in] prob_bits The number of bits used to describe probabilities, at most RANS_CONTEXT_MAX_BITS.
+     */
+    rANSContextModel(const uint32_t* syms, size_t n, size_t alphabet, uint32_t order, uint32_t prob_bits = 14);
+
+    /**
+     * @brief Builds a static model from the tables written by write_tables.
+     *
+     * @param[in] alphabet Size of the alphabet.
+     * @param[in] order 1 or 2.
+     * @param[in] prob_bits The number of bits used to describe probabilities, at most RANS_CONTEXT_MAX_BITS.
+     * @param[in] tables The tables.
+     * @param[in] size Number of words available at tables.
+     * @param[out] used Receives the number of words read, or 0 if the tables are malformed.
+     */
+    rANSContextModel(size_t alphabet, uint32_t order, uint32_t prob_bits, const uint32_t* tables, size_t size,
+                     size_t* used);
+
+    /**
+     * @brief Appends the tables of a static model.
+     *
+     * @details Only contexts that occur are written: the number of such contexts, then for each one its index, the
+     * number m of symbols with a frequency and m words holding symbol << 16 | (frequency - 1).
+     */
+    void write_tables(std::vector<uint32_t>& out) const;
+
+    size_t size() const { return alphabet; }
+    uint32_t get_order() const { return order; }
+    uint32_t get_prob_bits() const { return prob_bits; }
+    bool is_adaptive() const { return adaptive; }
+    uint32_t get_increment() const { return increment; }
+    uint32_t get_limit() const { return limit; }
+    uint32_t get_interval() const { return interval; }
+
+    /**
+     * @brief Returns the context following the symbols prev1, the previous one, and prev2, the one before.
+     */
+    size_t context(uint32_t prev1, uint32_t prev2) const {
+        if (order == 1) return prev1;
+        return prev1 * reduced + prev2 * reduced / alphabet;
+    }
+
+    const uint32_t* get_cdf(size_t ctx) const { return cdfs.data() + ctx * (alphabet + 1); }
+
+    uint32_t find_symbol(size_t ctx, uint32_t cum_prob) const {
+        return rANSFindSymbol(get_cdf(ctx), alphabet, cum_prob);
+    }
+
+    /**
+     * @brief Learns a symbol coded in context ctx. Does nothing for static models.
+     */
+    void update(size_t ctx, uint32_t sym) {
+        if (!adaptive) return;
+
+        counts[ctx * alphabet + sym] += increment;
+        totals[ctx] += increment;
+        if (totals[ctx] > limit) rescale(ctx);
+
+        // rebuild after 1, 2, 4, ... symbols of the context, then every interval symbols
+        uint32_t s = ++seen[ctx];
+        if (s % interval == 0 || (s < interval && (s & (s - 1)) == 0)) rebuild(ctx);
+    }
+
+};
+
+#endif //CLIONSCRATCHPAD_RANSCONTEXTMODEL_H
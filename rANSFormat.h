@@ -0,0 +1,70 @@
+//
+// Markers of the self-contained stream formats.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSFORMAT_H
+#define CLIONSCRATCHPAD_RANSFORMAT_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+// Self-contained stream formats start with a marker word. Its upper 16 bits hold RANS_FORMAT_MAGIC, followed by
+// 8 bits of format id and 8 bits of format parameter.
+#define RANS_FORMAT_MAGIC 0x72410000u
+#define RANS_FORMAT_MARKER(format, param) (RANS_FORMAT_MAGIC | ((uint32_t)(format) << 8) | (uint32_t)(param))
+
+// Returns true if word is a marker of the given format, whatever its parameter.
+#define RANS_FORMAT_IS(word, format) (((word) & ~0xffu) == RANS_FORMAT_MARKER(format, 0))
+
+#define RANS_FORMAT_INTERLEAVED 0x01    // param: number of interleaved 64-bit states
+#define RANS_FORMAT_WIDE 0x02           // param: number of 32-bit lanes
+#define RANS_FORMAT_BLOCKS 0x03         // param: container version
+#define RANS_FORMAT_CONTEXT 0x04        // param: context order, RANS_CONTEXT_ADAPTIVE for adaptive models
+#define RANS_FORMAT_TANS 0x05           // param: prob_bits
+#define RANS_FORMAT_STREAM 0x06         // param: frame version
+#define RANS_FORMAT_STATIC 0x07         // param: header version
+
+#define RANS_BLOCKS_VERSION 1
+#define RANS_BLOCKS_HEADER_WORDS 5      // marker, symbol count (2), block size, block count
+#define RANS_BLOCKS_INDEX_WORDS 3       // offset (2), size
+
+#define RANS_CONTEXT_ADAPTIVE 0x80
+#define RANS_CONTEXT_HEADER_WORDS 5     // marker, symbol count (2), alphabet, prob_bits
+#define RANS_CONTEXT_ADAPTIVE_WORDS 3   // increment, limit, interval
+
+#define RANS_TANS_HEADER_WORDS 3        // marker, payload bits (2)
+
+#define RANS_STREAM_VERSION 1
+#define RANS_STREAM_FRAME_WORDS 3       // marker, symbol count, payload words
+
+#define RANS_STATIC_VERSION 1
+#define RANS_STATIC_HEADER_WORDS 2      // marker, number of words holding the header bytes
+#define RANS_STATIC_MAX_BITS 31
+#define RANS_STATIC_MAX_ALPHABET (1 << 24)
+
+// Appends v as a varint: 7 bits per byte starting with the least significant ones, the high bit set on all bytes but
+// the last.
+static inline void rANSPutVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t) (v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t) v);
+}
+
+// Reads a varint at *pptr, moving it past the varint. Returns false if the varint does not end before end.
+static inline bool rANSGetVarint(const uint8_t** pptr, const uint8_t* end, uint64_t* v) {
+    uint64_t r = 0;
+    for (uint32_t shift = 0; *pptr < end && shift < 64; shift += 7) {
+        uint8_t b = *(*pptr)++;
+        r |= (uint64_t) (b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif //CLIONSCRATCHPAD_RANSFORMAT_H
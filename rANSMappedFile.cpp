@@ -0,0 +1,39 @@
+//
+// Read-only memory mapping of an encoded file.
+//
+
+#include "rANSMappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+
+rANSMappedFile::rANSMappedFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cout << "ERROR: Could not open " << path << "." << std::endl;
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % sizeof(uint32_t) != 0) {
+        std::cout << "ERROR: " << path << " is empty or not a file of 32-bit words." << std::endl;
+        close(fd);
+        return;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cout << "ERROR: Could not map " << path << "." << std::endl;
+        return;
+    }
+    addr = map;
+    bytes = st.st_size;
+}
+
+rANSMappedFile::~rANSMappedFile() {
+    if (addr) munmap(addr, bytes);
+}
@@ -0,0 +1,52 @@
+//
+// Read-only memory mapping of an encoded file.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSMAPPEDFILE_H
+#define CLIONSCRATCHPAD_RANSMAPPEDFILE_H
+
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * @brief Maps a file of 32-bit words into memory, read-only, for the decoders to read in place.
+ *
+ * @details Nothing is read when the file is opened: the pages are loaded from the page cache as the decoder touches
+ * them, and processes mapping the same file share them. The mapping is released with the object.
+ *
+ * Example usage:
+ *
+ *     rANSMappedFile file("encoded.rans");
+ *     if (file.is_open()) {
+ *         coder.decode_blocks(file.data(), file.size(), model, out);
+ *     }
+ */
+class rANSMappedFile {
+
+private:
+
+    void* addr = nullptr;
+    size_t bytes = 0;
+
+public:
+
+    /**
+     * @brief Maps a file. Prints an error and leaves the object closed if the file cannot be mapped, is empty or its
+     * size is not a multiple of 4 bytes.
+     *
+     * @param[in] path Path of the file.
+     */
+    explicit rANSMappedFile(const char* path);
+
+    rANSMappedFile(const rANSMappedFile&) = delete;
+    rANSMappedFile& operator=(const rANSMappedFile&) = delete;
+
+    ~rANSMappedFile();
+
+    bool is_open() const { return addr != nullptr; }
+    const uint32_t* data() const { return (const uint32_t*) addr; }
+    size_t size() const { return bytes / sizeof(uint32_t); }
+
+};
+
+#endif //CLIONSCRATCHPAD_RANSMAPPEDFILE_H
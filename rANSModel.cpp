@@ -0,0 +1,200 @@
+//
+// Static frequency model for the rANSCoder.
+//
+
+#include "rANSModel.h"
+#include <iostream>
+
+// Every symbol must be able to get a frequency of at least 1.
+static bool check_alphabet(size_t size, uint32_t prob_bits) {
+    if (size < 1 || size > ((uint64_t) 1 << prob_bits)) {
+        std::cout << "ERROR: A model needs 1 to 2^prob_bits symbols, got " << size << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+rANSModel::rANSModel(const std::vector<float>& pdf, uint32_t floatshift, uint32_t prob_bits, bool legacy_quantization)
+    : prob_bits(prob_bits), freqs(pdf.size()), cdf(pdf.size()+1) {
+
+    if (!check_alphabet(pdf.size(), prob_bits)) {
+        freqs.clear();
+        cdf.clear();
+        return;
+    }
+    if (!legacy_quantization) {
+        rANSQuantizePdf(pdf.data(), pdf.size(), prob_bits, freqs.data(), cdf.data());
+        init_symbols();
+        return;
+    }
+
+    std::vector<uint32_t> counts(pdf.size());
+    for (size_t i = 0; i<pdf.size(); i++) {
+        counts[i] = pdf[i]*floatshift;
+    }
+
+    quantize(counts.data(), counts.size(), prob_bits, 1, freqs.data(), cdf.data());
+    init_symbols();
+}
+
+rANSModel::rANSModel(const std::vector<uint32_t>& counts, uint32_t prob_bits, bool legacy_quantization)
+    : prob_bits(prob_bits), freqs(counts.size()), cdf(counts.size()+1) {
+
+    if (!check_alphabet(counts.size(), prob_bits)) {
+        freqs.clear();
+        cdf.clear();
+        return;
+    }
+    if (legacy_quantization) {
+        quantize(counts.data(), counts.size(), prob_bits, 1, freqs.data(), cdf.data());
+    } else {
+        rANSQuantizeCounts(counts.data(), counts.size(), prob_bits, freqs.data(), cdf.data());
+    }
+    init_symbols();
+}
+
+rANSModel::rANSModel(const uint32_t* freqs, size_t size, uint32_t prob_bits)
+    : prob_bits(prob_bits), freqs(freqs, freqs + size) {
+
+    uint64_t total = 0;
+    for (size_t i = 0; i<size; i++) {
+        total += freqs[i];
+    }
+    if (size < 1 || total != ((uint64_t) 1 << prob_bits)) {
+        std::cout << "ERROR: Model frequencies must sum to 2^prob_bits." << std::endl;
+        this->freqs.clear();
+        return;
+    }
+    init_cdf();
+}
+
+rANSModel::rANSModel(const uint8_t* table, size_t size, size_t alphabet, uint32_t prob_bits, size_t* used)
+    : prob_bits(prob_bits) {
+
+    *used = 0;
+    const uint8_t* ptr = table;
+    const uint8_t* end = table + size;
+    const uint64_t scale = (uint64_t) 1 << prob_bits;
+
+    uint64_t m;
+    if (!rANSGetVarint(&ptr, end, &m) || m < 1 || m > alphabet) return;
+
+    std::vector<uint32_t> table_freqs(alphabet, 0);
+    uint64_t sym = 0, total = 0;
+    int64_t prev = 0;
+    for (uint64_t k = 0; k + 1 < m; k++) {
+        uint64_t token, gap = 0;
+        if (!rANSGetVarint(&ptr, end, &token)) return;
+        if ((token & 1) && !rANSGetVarint(&ptr, end, &gap)) return;
+        if (gap >= alphabet || (token >> 2) > scale) return;
+        sym += (token & 1) ? gap + 1 : 0;
+
+        uint64_t zz = token >> 1;
+        int64_t freq = prev + (int64_t) ((zz >> 1) ^ (~(zz & 1) + 1));
+        if (sym >= alphabet || freq < 1 || (uint64_t) freq >= scale - total) return;
+        table_freqs[sym++] = (uint32_t) freq;
+        total += freq;
+        prev = freq;
+    }
+
+    uint64_t gap;
+    if (!rANSGetVarint(&ptr, end, &gap) || gap >= alphabet - sym) return;
+    table_freqs[sym + gap] = (uint32_t) (scale - total);
+
+    freqs.swap(table_freqs);
+    init_cdf();
+    *used = ptr - table;
+}
+
+void rANSModel::init_cdf() {
+    cdf.resize(freqs.size() + 1);
+    cdf[0] = 0;
+    for (size_t i = 0; i<freqs.size(); i++) {
+        cdf[i+1] = cdf[i] + freqs[i];
+    }
+    init_symbols();
+}
+
+void rANSModel::write_table(std::vector<uint8_t>& out) const {
+    size_t m = 0;
+    size_t last = 0;
+    for (size_t i = 0; i<freqs.size(); i++) {
+        if (freqs[i]) {
+            m++;
+            last = i;
+        }
+    }
+    rANSPutVarint(out, m);
+
+    size_t next = 0;
+    int64_t prev = 0;
+    for (size_t i = 0; i<last; i++) {
+        if (!freqs[i]) continue;
+
+        int64_t delta = (int64_t) freqs[i] - prev;
+        uint64_t zz = ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63);
+        if (i > next) {
+            rANSPutVarint(out, zz << 1 | 1);
+            rANSPutVarint(out, i - next - 1);
+        } else {
+            rANSPutVarint(out, zz << 1);
+        }
+        next = i + 1;
+        prev = freqs[i];
+    }
+    rANSPutVarint(out, last - next);
+}
+
+void rANSModel::quantize(const uint32_t* counts, size_t size, uint32_t prob_bits, uint32_t min_count,
+                         uint32_t* npdf, uint32_t* cdf) {
+
+    for (size_t i = 0; i<size; i++) {
+        npdf[i] = counts[i] < min_count ? min_count : counts[i];
+    }
+
+    cdf[0] = 0;
+    for(size_t i = 0; i<size; i++) {
+        cdf[i+1] = cdf[i] + npdf[i];
+    }
+
+    uint32_t cur_total = cdf[size];
+    for (size_t i = 1; i <= size; i++) {
+        // cdf has to be strictly increasing
+        cdf[i] = ((uint64_t)1 << prob_bits) * cdf[i] / cur_total;
+    }
+
+    for (size_t i = 0; i<size; i++) {
+        npdf[i] = cdf[i + 1] - cdf[i];
+    }
+}
+
+void rANSModel::init_symbols() {
+    enc_syms.resize(freqs.size());
+    for (size_t i = 0; i<freqs.size(); i++) {
+        Rans64EncSymbolInit(&enc_syms[i], cdf[i], freqs[i], prob_bits);
+    }
+
+    if (prob_bits > RANS_MODEL_TABLE_MAX_BITS) return;
+    for (size_t i = 0; i<freqs.size(); i++) {
+        // a single symbol holding all of 1 << 16 does not fit the packed entry
+        if (freqs[i] > 0xffff) return;
+    }
+
+    slots.resize((size_t)1 << prob_bits);
+    for (size_t i = 0; i<freqs.size(); i++) {
+        for (uint32_t j = cdf[i]; j < cdf[i+1]; j++) {
+            slots[j].freq = freqs[i];
+            slots[j].start = cdf[i];
+            slots[j].sym = i;
+        }
+    }
+}
+
+size_t rANSModel::estimate_words(const uint32_t* syms, size_t n) const {
+    uint64_t bits = 0;
+    for (size_t i = 0; i<n; i++) {
+        bits += rANSSymbolCost(freqs[syms[i]], prob_bits);
+    }
+
+    return rANSCostWords(bits);
+}
@@ -0,0 +1,211 @@
+//
+// Static frequency model for the rANSCoder.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSMODEL_H
+#define CLIONSCRATCHPAD_RANSMODEL_H
+
+#include "rans64_custom.hpp"
+#include "rANSSearch.h"
+#include "rANSQuantize.h"
+#include "rANSFormat.h"
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+// Largest prob_bits for which a model builds a slot->symbol lookup table. At 16 bits the table takes 512 KiB, at the
+// default of 14 bits 128 KiB, so it stays cache resident.
+#define RANS_MODEL_TABLE_MAX_BITS 16
+
+// Fractional bits of rANSSymbolCost.
+#define RANS_COST_BITS 23
+
+/**
+ * @brief Returns the cost of coding a symbol of frequency freq, in bits with RANS_COST_BITS fractional bits.
+ *
+ * @details log2 of the frequency is read off its bits as a float, exponent plus mantissa. That overestimates the cost
+ * by at most 0.09 bits, without a table or a call to log2. All encoders size their output with it, see rANSCostWords.
+ */
+static inline uint64_t rANSSymbolCost(uint32_t freq, uint32_t prob_bits) {
+    float f = (float) freq;
+    uint32_t repr;
+    memcpy(&repr, &f, sizeof(repr));
+    return ((uint64_t) (prob_bits + 127) << RANS_COST_BITS) - repr;
+}
+
+/**
+ * @brief Returns the number of words symbols costing bits in all, summed from rANSSymbolCost, encode to: the bits
+ * rounded up to whole words, plus the flushed state.
+ */
+static inline size_t rANSCostWords(uint64_t bits) {
+    return (size_t) (((bits >> RANS_COST_BITS) + 31) / 32) + 2;
+}
+
+// Decoder lookup table entry. freq and start come first so both can be fetched with a single 32-bit load.
+typedef struct {
+    uint16_t freq;      // Symbol frequency.
+    uint16_t start;     // Start of range.
+    uint32_t sym;       // Symbol.
+} rANSDecSlot;
+
+/**
+ * @brief A precomputed, quantized probability distribution for the rANSCoder.
+ *
+ * @details When the same probability distribution is used for many symbols, quantizing it again for every symbol is
+ * wasted work. A rANSModel is built once, either from a probability distribution or from integer counts, and caches
+ * everything the coder needs: the quantized frequencies, the cumulative distribution and the reciprocals used by the
+ * multiply-based encoder.
+ *
+ * The quantization is exactly the one the rANSCoder applies to a float distribution, so encoding a symbol with a
+ * model built from a pdf gives the same output as encoding it with the pdf itself.
+ *
+ * Example usage:
+ *
+ *     std::vector<float> probs{0.25, 0.25, 0.5};
+ *     rANSModel model(probs);
+ *
+ *     rANSCoder encoder;
+ *     encoder.init_ec();
+ *     encoder.encode_sym(1, model);
+ *     encoder.encode_sym(2, model);
+ *
+ * @attention The model must be built with the same prob_bits as the coder using it.
+ */
+class rANSModel {
+
+private:
+
+    uint32_t prob_bits;
+    std::vector<uint32_t> freqs;
+    std::vector<uint32_t> cdf;
+    std::vector<Rans64EncSymbol> enc_syms;
+    std::vector<rANSDecSlot> slots;
+
+    void init_symbols();
+    void init_cdf();
+
+public:
+
+    /**
+     * @brief Builds a model from a probability distribution.
+     *
+     * @details The distribution is quantized with rANSQuantizePdf, or like the rANSCoder's default if
+     * legacy_quantization is set, see rANSCoder::set_legacy_quantization.
+     *
+     * @param[in] pdf Probability distribution, where pdf[i] is the probability of symbol i.
+     * @param[in] floatshift A power of 2. Describes how many decimal positions are used to calculate the buckets.
+     * Only used by the legacy quantization.
+     * @param[in] prob_bits The number of bits used to describe probabilities.
+     * @param[in] legacy_quantization true to quantize like rANSCoder::set_legacy_quantization(true).
+     *
+     * @attention The pdf must have 1 to 2 to the power of prob_bits entries, otherwise the model is left empty.
+     */
+    rANSModel(const std::vector<float>& pdf, uint32_t floatshift = 1 << 11, uint32_t prob_bits = 14,
+              bool legacy_quantization = false);
+
+    /**
+     * @brief Builds a model from integer counts.
+     *
+     * @details The counts do not need to sum to anything in particular, they are rescaled to 2 to the power of
+     * prob_bits with rANSQuantizeCounts. Symbols with a count of 0 still receive a frequency of 1.
+     *
+     * @param[in] counts Number of occurrences, where counts[i] belongs to symbol i.
+     * @param[in] prob_bits The number of bits used to describe probabilities.
+     * @param[in] legacy_quantization true to rescale the counts with quantize instead, as earlier versions did.
+     *
+     * @attention There must be 1 to 2 to the power of prob_bits counts, otherwise the model is left empty.
+     */
+    rANSModel(const std::vector<uint32_t>& counts, uint32_t prob_bits = 14, bool legacy_quantization = false);
+
+    /**
+     * @brief Builds a model from quantized frequencies, which are used as they are.
+     *
+     * @param[in] freqs Array of size frequencies summing to 2 to the power of prob_bits. Symbols with a frequency of 0
+     * cannot be coded.
+     * @param[in] size Size of the alphabet.
+     * @param[in] prob_bits The number of bits used to describe probabilities.
+     *
+     * @attention Frequencies that do not sum to 2 to the power of prob_bits leave the model empty.
+     */
+    rANSModel(const uint32_t* freqs, size_t size, uint32_t prob_bits);
+
+    /**
+     * @brief Builds a model from a table written by write_table.
+     *
+     * @param[in] table The table.
+     * @param[in] size Number of bytes available at table.
+     * @param[in] alphabet Size of the alphabet.
+     * @param[in] prob_bits The number of bits used to describe probabilities.
+     * @param[out] used Receives the number of bytes read, or 0 if the table is malformed, which leaves the model empty.
+     */
+    rANSModel(const uint8_t* table, size_t size, size_t alphabet, uint32_t prob_bits, size_t* used);
+
+    /**
+     * @brief Appends the quantized frequencies in a compact form, for the model to travel with the encoded text.
+     *
+     * @details Only symbols with a frequency are written: first their number m, then for each of them but the last
+     * the difference of its frequency to the one before, zigzag coded and shifted left by one bit. The low bit is set
+     * when symbols with a frequency of 0 precede the symbol, and their number minus one follows. The last symbol is
+     * written as the number of symbols with a frequency of 0 before it, its frequency is what remains of 2 to the
+     * power of prob_bits. All numbers are varints, see rANSPutVarint, so a smooth distribution takes about a byte per
+     * symbol.
+     */
+    void write_table(std::vector<uint8_t>& out) const;
+
+    /**
+     * @brief Quantizes integer counts into frequencies summing to 2 to the power of prob_bits.
+     *
+     * @details This is the legacy quantization shared by the rANSCoder and the rANSModel. The rescaling rounds down,
+     * so symbols with small counts can end up with a frequency of 0. See rANSQuantizeCounts for the default one.
+     *
+     * @param[in] counts Array of size counts.
+     * @param[in] size Size of the alphabet.
+     * @param[in] prob_bits The number of bits used to describe probabilities.
+     * @param[in] min_count Counts below this value are raised to it.
+     * @param[out] npdf Array of size quantized frequencies.
+     * @param[out] cdf Array of size+1 cumulative frequencies, starting with 0.
+     */
+    static void quantize(const uint32_t* counts, size_t size, uint32_t prob_bits, uint32_t min_count,
+                         uint32_t* npdf, uint32_t* cdf);
+
+    uint32_t get_prob_bits() const { return prob_bits; }
+    size_t size() const { return freqs.size(); }
+    const uint32_t* get_freqs() const { return freqs.data(); }
+    const uint32_t* get_cdf() const { return cdf.data(); }
+    const Rans64EncSymbol* get_enc_symbols() const { return enc_syms.data(); }
+
+    /**
+     * @brief Estimates the number of 32-bit words encoding the given symbols takes.
+     *
+     * @details Sums the information content -log2(freq/scale) of the symbols under the model with rANSSymbolCost and
+     * converts it with rANSCostWords. The cost is overestimated, so the actual output is a little smaller, by up to
+     * about a tenth for very skewed distributions.
+     *
+     * @param[in] syms Array of n symbols.
+     * @param[in] n Number of symbols.
+     * @return The estimated size in words.
+     */
+    size_t estimate_words(const uint32_t* syms, size_t n) const;
+
+    /**
+     * @brief Returns the decoder lookup table, or nullptr if the model has none.
+     *
+     * @details The table has 2 to the power of prob_bits entries, entry i describes the symbol whose bucket contains
+     * the cumulative frequency i. It is only built when prob_bits is at most RANS_MODEL_TABLE_MAX_BITS.
+     */
+    const rANSDecSlot* get_slots() const { return slots.empty() ? nullptr : slots.data(); }
+
+    /**
+     * @brief Returns the symbol whose bucket contains the cumulative frequency cum_prob.
+     *
+     * @details This is a single load when the model has a lookup table, and a search over the cdf otherwise.
+     */
+    uint32_t find_symbol(uint32_t cum_prob) const {
+        if (!slots.empty()) return slots[cum_prob].sym;
+        return rANSFindSymbol(cdf.data(), freqs.size(), cum_prob);
+    }
+
+};
+
+
+#endif //CLIONSCRATCHPAD_RANSMODEL_H
@@ -0,0 +1,91 @@
+//
+// Precomputed tables of parametric distributions for the rANSCoder.
+//
+
+#include "rANSParametricBank.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+rANSParametricBank::rANSParametricBank(rANSFamily family, const std::vector<float>& scales, uint32_t prob_bits,
+                                       double tail_mass)
+    : family(family), prob_bits(prob_bits), scales(scales) {
+
+    // the smallest table, the mean and the escape, already takes two frequencies
+    if (prob_bits < 1) {
+        std::cout << "ERROR: Parametric banks need at least 1 prob_bit." << std::endl;
+        this->scales.clear();
+        return;
+    }
+    std::sort(this->scales.begin(), this->scales.end());
+
+    // leave at least three quarters of the frequencies to the distribution itself
+    const uint32_t max_tail = prob_bits > 3 ? (1u << (prob_bits - 3)) - 1 : 0;
+
+    std::vector<float> pdf;
+    size_t offset = 0;
+    for (size_t k = 0; k < this->scales.size(); k++) {
+        double scale = std::max<double>(this->scales[k], 1e-6);
+
+        uint32_t tail = 0;
+        while (tail < max_tail && 2 * survival(tail + 0.5, scale) > tail_mass) tail++;
+
+        // the probability of a residual r is computed from the survival function on both sides, which keeps its
+        // precision far out in the tails
+        size_t alphabet = 2 * tail + 2;
+        pdf.resize(alphabet);
+        pdf[tail] = (float) (1 - 2 * survival(0.5, scale));
+        for (uint32_t r = 1; r <= tail; r++) {
+            float p = (float) (survival(r - 0.5, scale) - survival(r + 0.5, scale));
+            pdf[tail + r] = p;
+            pdf[tail - r] = p;
+        }
+        pdf[alphabet - 1] = (float) (2 * survival(tail + 0.5, scale));
+
+        tails.push_back(tail);
+        offsets.push_back(offset);
+        cdfs.resize(offset + k + alphabet + 1);
+        enc_syms.resize(offset + alphabet);
+
+        std::vector<uint32_t> freqs(alphabet);
+        uint32_t* cdf = cdfs.data() + offset + k;
+        rANSQuantizePdf(pdf.data(), alphabet, prob_bits, freqs.data(), cdf);
+        for (size_t i = 0; i < alphabet; i++) {
+            Rans64EncSymbolInit(&enc_syms[offset + i], cdf[i], freqs[i], prob_bits);
+        }
+
+        offset += alphabet;
+    }
+}
+
+double rANSParametricBank::survival(double x, double scale) const {
+    switch (family) {
+        case RANS_LAPLACE:
+            return 0.5 * std::exp(-x / scale);
+        case RANS_LOGISTIC:
+            return 1 / (1 + std::exp(x / scale));
+        default:
+            return 0.5 * std::erfc(x / (scale * std::sqrt(2.0)));
+    }
+}
+
+std::vector<float> rANSParametricBank::log_scales(float min_scale, float max_scale, size_t count) {
+    std::vector<float> out(count);
+    double lo = std::log((double) min_scale);
+    double hi = std::log((double) max_scale);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (float) std::exp(count > 1 ? lo + (hi - lo) * i / (count - 1) : lo);
+    }
+    return out;
+}
+
+uint32_t rANSParametricBank::scale_index(float scale) const {
+    size_t above = std::upper_bound(scales.begin(), scales.end(), scale) - scales.begin();
+    return above > 0 ? (uint32_t) (above - 1) : 0;
+}
+
+void rANSParametricBank::scale_indices(const float* scales, size_t n, uint32_t* out) const {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = scale_index(scales[i]);
+    }
+}
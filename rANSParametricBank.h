@@ -0,0 +1,113 @@
+//
+// Precomputed tables of parametric distributions for the rANSCoder.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSPARAMETRICBANK_H
+#define CLIONSCRATCHPAD_RANSPARAMETRICBANK_H
+
+#include "rans64_custom.hpp"
+#include "rANSSearch.h"
+#include "rANSQuantize.h"
+#include <vector>
+#include <cstddef>
+
+// Default probability of a value falling outside the table of its scale. Such values are coded as an escape symbol
+// followed by 32 raw bits.
+#define RANS_PARAMETRIC_TAIL_MASS 1e-6
+
+// Number of raw bits per coder step when an escaped value is written, the value takes two steps.
+#define RANS_PARAMETRIC_RAW_BITS 16
+
+enum rANSFamily {
+    RANS_GAUSSIAN = 0,
+    RANS_LAPLACE = 1,
+    RANS_LOGISTIC = 2
+};
+
+/**
+ * @brief A bank of quantized cdfs of one distribution family, one per scale.
+ *
+ * @details Learned codecs predict a mean and a scale per symbol. Building and quantizing a pdf for every symbol costs
+ * far more than coding it, so the bank quantizes the zero-mean distribution once for each of a discrete set of
+ * scales. A symbol is then coded relative to its rounded mean with the table of its scale index.
+ *
+ * The table of scale s covers the residuals [-tail, tail], where tail is the smallest value leaving at most tail_mass
+ * of the distribution outside, plus an escape symbol. Residuals outside the table are coded as the escape symbol
+ * followed by the residual itself in raw bits, so any int32 value can be coded.
+ *
+ * The tables of all scales share one contiguous array. A bank is never modified after construction, so one bank can
+ * be shared by any number of coders and threads.
+ *
+ * Example usage:
+ *
+ *     rANSParametricBank bank(RANS_GAUSSIAN, rANSParametricBank::log_scales(0.11f, 256.0f, 64));
+ *     bank.scale_indices(scales, n, indices);
+ *
+ *     rANSCoder encoder;
+ *     encoder.encode_batch_parametric(syms, means, indices, n, bank);
+ */
+class rANSParametricBank {
+
+private:
+
+    rANSFamily family;
+    uint32_t prob_bits;
+    std::vector<float> scales;
+    std::vector<uint32_t> tails;
+    std::vector<size_t> offsets;
+    std::vector<uint32_t> cdfs;
+    std::vector<Rans64EncSymbol> enc_syms;
+
+    double survival(double x, double scale) const;
+
+public:
+
+    /**
+     * @brief Builds the tables of a distribution family for the given scales.
+     *
+     * @param[in] family Distribution of the symbols around their mean.
+     * @param[in] scales Positive scales, kept in increasing order: the standard deviation for RANS_GAUSSIAN, the
+     * diversity b for RANS_LAPLACE and s for RANS_LOGISTIC.
+     * @param[in] prob_bits The number of bits used to describe probabilities, at least 1. Must match the coder. With
+     * 0 the bank is left without scales.
+     * @param[in] tail_mass Largest probability of a residual falling outside its table. Tables are limited to a
+     * quarter of 2 to the power of prob_bits entries, which can leave more for very large scales.
+     */
+    rANSParametricBank(rANSFamily family, const std::vector<float>& scales, uint32_t prob_bits = 14,
+                       double tail_mass = RANS_PARAMETRIC_TAIL_MASS);
+
+    /**
+     * @brief Returns count scales spaced evenly in log space from min_scale to max_scale.
+     */
+    static std::vector<float> log_scales(float min_scale, float max_scale, size_t count);
+
+    /**
+     * @brief Returns the index of the largest scale of the bank not above scale, or 0 if all are above.
+     */
+    uint32_t scale_index(float scale) const;
+
+    /**
+     * @brief Maps n scales to indices with scale_index.
+     */
+    void scale_indices(const float* scales, size_t n, uint32_t* out) const;
+
+    rANSFamily get_family() const { return family; }
+    uint32_t get_prob_bits() const { return prob_bits; }
+    size_t size() const { return scales.size(); }
+    float get_scale(uint32_t index) const { return scales[index]; }
+
+    /**
+     * @brief Returns the half width of the table of a scale. Its symbols are the residuals -tail..tail, followed by
+     * the escape symbol 2 * tail + 1.
+     */
+    uint32_t get_tail(uint32_t index) const { return tails[index]; }
+    const uint32_t* get_cdf(uint32_t index) const { return cdfs.data() + offsets[index] + index; }
+    const Rans64EncSymbol* get_enc_symbols(uint32_t index) const { return enc_syms.data() + offsets[index]; }
+
+    uint32_t find_symbol(uint32_t index, uint32_t cum_prob) const {
+        return rANSFindSymbol(get_cdf(index), 2 * tails[index] + 2, cum_prob);
+    }
+
+};
+
+#endif //CLIONSCRATCHPAD_RANSPARAMETRICBANK_H
@@ -0,0 +1,178 @@
+//
+// Full precision quantization of probability distributions.
+//
+
+#include "rANSQuantize.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Converts the probabilities to fixed point counts and returns their sum.
+static uint64_t fixed_counts(const float* pdf, size_t size, uint32_t* counts)
+{
+    const float scale = (float) (1u << RANS_QUANT_FIXED_BITS);
+    uint64_t total = 0;
+    size_t i = 0;
+
+#if defined(__GNUC__) && defined(__AVX2__)
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale8 = _mm256_set1_ps(scale);
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 8 <= size; i += 8) {
+        // max returns its second operand for NaNs, like the scalar comparison below
+        __m256 p = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(pdf + i), zero), one);
+        __m256i c = _mm256_cvttps_epi32(_mm256_mul_ps(p, scale8));
+        _mm256_storeu_si256((__m256i*) (counts + i), c);
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(c)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(c, 1)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*) lanes, acc);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; i < size; i++) {
+        float p = pdf[i] > 0.0f ? pdf[i] : 0.0f;
+        p = p < 1.0f ? p : 1.0f;
+        counts[i] = (uint32_t) (p * scale);
+        total += counts[i];
+    }
+
+    return total;
+}
+
+// freqs[i] = max(1, floor(counts[i] * scale)). The vector path needs counts and results below 2^31.
+static void floor_counts(const uint32_t* counts, size_t size, double scale, bool small, uint32_t* freqs)
+{
+    size_t i = 0;
+
+#if defined(__GNUC__) && defined(__AVX2__)
+    if (small) {
+        const __m256d scale4 = _mm256_set1_pd(scale);
+        const __m128i one = _mm_set1_epi32(1);
+        for (; i + 4 <= size; i += 4) {
+            __m256d c = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*) (counts + i)));
+            __m128i f = _mm256_cvttpd_epi32(_mm256_floor_pd(_mm256_mul_pd(c, scale4)));
+            _mm_storeu_si128((__m128i*) (freqs + i), _mm_max_epi32(f, one));
+        }
+    }
+#endif
+
+    for (; i < size; i++) {
+        uint32_t f = (uint32_t) std::floor((double) counts[i] * scale);
+        freqs[i] = f > 0 ? f : 1;
+    }
+}
+
+// Adds or removes units until the frequencies sum to 1 << prob_bits, where they cost the fewest bits.
+static void distribute(const uint32_t* counts, size_t size, uint32_t prob_bits, uint32_t* freqs)
+{
+    static thread_local std::vector<uint32_t> order;
+
+    const uint64_t scale = (uint64_t) 1 << prob_bits;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += freqs[i];
+    }
+
+    if (sum < scale) {
+        // gain of one more unit is about c/(f+1/2), compare c_a/(2f_a+1) > c_b/(2f_b+1) without dividing
+        auto more = [&](uint32_t a, uint32_t b) {
+            uint64_t ga = (uint64_t) counts[a] * (2 * (uint64_t) freqs[b] + 1);
+            uint64_t gb = (uint64_t) counts[b] * (2 * (uint64_t) freqs[a] + 1);
+            return ga != gb ? ga > gb : a < b;
+        };
+
+        uint64_t left = scale - sum;
+        while (left > 0) {
+            size_t k = (size_t) std::min<uint64_t>(left, size);
+            order.resize(size);
+            for (size_t i = 0; i < size; i++) {
+                order[i] = (uint32_t) i;
+            }
+            if (k < size) {
+                std::nth_element(order.begin(), order.begin() + k, order.end(), more);
+            }
+
+            for (size_t j = 0; j < k; j++) {
+                freqs[order[j]]++;
+            }
+            left -= k;
+        }
+    } else if (sum > scale) {
+        // cost of one unit less is about c/(f-1/2), the heap keeps the cheapest symbol on top
+        auto costlier = [&](uint32_t a, uint32_t b) {
+            uint64_t ca = (uint64_t) counts[a] * (2 * (uint64_t) freqs[b] - 1);
+            uint64_t cb = (uint64_t) counts[b] * (2 * (uint64_t) freqs[a] - 1);
+            return ca != cb ? ca > cb : a > b;
+        };
+
+        order.clear();
+        for (size_t i = 0; i < size; i++) {
+            if (freqs[i] > 1) order.push_back((uint32_t) i);
+        }
+        std::make_heap(order.begin(), order.end(), costlier);
+
+        uint64_t excess = sum - scale;
+        while (excess > 0 && !order.empty()) {
+            std::pop_heap(order.begin(), order.end(), costlier);
+            uint32_t s = order.back();
+            order.pop_back();
+
+            freqs[s]--;
+            excess--;
+            if (freqs[s] > 1) {
+                order.push_back(s);
+                std::push_heap(order.begin(), order.end(), costlier);
+            }
+        }
+    }
+}
+
+static void quantize(const uint32_t* counts, size_t size, uint64_t total, bool small, uint32_t prob_bits,
+                     uint32_t* freqs, uint32_t* cdf)
+{
+    const uint64_t scale = (uint64_t) 1 << prob_bits;
+
+    if (total == 0) {
+        for (size_t i = 0; i < size; i++) {
+            freqs[i] = (uint32_t) (scale / size + (i < scale % size));
+        }
+    } else {
+        floor_counts(counts, size, (double) scale / (double) total, small && prob_bits < 31, freqs);
+        distribute(counts, size, prob_bits, freqs);
+    }
+
+    cdf[0] = 0;
+    for (size_t i = 0; i < size; i++) {
+        cdf[i + 1] = cdf[i] + freqs[i];
+    }
+}
+
+void rANSQuantizeCounts(const uint32_t* counts, size_t size, uint32_t prob_bits, uint32_t* freqs, uint32_t* cdf)
+{
+    uint64_t total = 0;
+    uint32_t largest = 0;
+    for (size_t i = 0; i < size; i++) {
+        total += counts[i];
+        largest = std::max(largest, counts[i]);
+    }
+
+    quantize(counts, size, total, largest < (1u << 31), prob_bits, freqs, cdf);
+}
+
+void rANSQuantizePdf(const float* pdf, size_t size, uint32_t prob_bits, uint32_t* freqs, uint32_t* cdf)
+{
+    static thread_local std::vector<uint32_t> counts;
+
+    counts.resize(size);
+    uint64_t total = fixed_counts(pdf, size, counts.data());
+
+    quantize(counts.data(), size, total, true, prob_bits, freqs, cdf);
+}
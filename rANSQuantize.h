@@ -0,0 +1,55 @@
+//
+// Full precision quantization of probability distributions.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSQUANTIZE_H
+#define CLIONSCRATCHPAD_RANSQUANTIZE_H
+
+#include <stdint.h>
+#include <cstddef>
+
+// Float probabilities are first converted to fixed point counts with this many fractional bits. This is exact for
+// every float in [2^-24, 1], so all of a float's mantissa is used.
+#define RANS_QUANT_FIXED_BITS 24
+
+/**
+ * @brief Quantizes integer counts into frequencies summing to 2 to the power of prob_bits.
+ *
+ * @details Every frequency is at least 1, so every symbol stays encodable, also ones with a count of 0. The counts are
+ * scaled in full precision and rounded down. The units left over by the rounding, or taken by raising
+ * frequencies to 1, are then handed out where they cost the fewest bits. A unit added to a symbol with count c and
+ * frequency f saves about c/(f+1/2) bits per count; a unit taken from it costs about c/(f-1/2). That gives the
+ * largest-remainder rounding, weighted by coding cost instead of by absolute error.
+ *
+ * The counts are scaled with one double multiplication per symbol and rounded down, everything after that is integer
+ * arithmetic. IEEE 754 rounds the multiplication the same way everywhere, and the AVX2 path performs the same one, so
+ * the result is the same on every machine and build that evaluates doubles in double precision (not x87 extended
+ * precision).
+ *
+ * @param[in] counts Array of size counts. If all are 0, the frequencies are spread uniformly.
+ * @param[in] size Size of the alphabet, at most 2 to the power of prob_bits.
+ * @param[in] prob_bits The number of bits used to describe probabilities.
+ * @param[out] freqs Array of size quantized frequencies.
+ * @param[out] cdf Array of size+1 cumulative frequencies, starting with 0.
+ */
+void rANSQuantizeCounts(const uint32_t* counts, size_t size, uint32_t prob_bits, uint32_t* freqs, uint32_t* cdf);
+
+/**
+ * @brief Quantizes a probability distribution into frequencies summing to 2 to the power of prob_bits.
+ *
+ * @details The probabilities are converted to RANS_QUANT_FIXED_BITS fixed point counts and quantized with
+ * rANSQuantizeCounts. Probabilities are clamped to [0, 1], NaNs count as 0. They do not need to sum to exactly 1.
+ *
+ * The fixed point conversion and the rounding of the counts are vectorized with AVX2 when the build targets it. The
+ * vector and scalar code perform the same exact operations, so the result does not depend on the instruction set.
+ * The vectorization runs within one distribution; the batch methods of the rANSCoder call this row by row.
+ *
+ * @param[in] pdf Probability distribution, where pdf[i] is the probability of symbol i.
+ * @param[in] size Size of the alphabet, at most 2 to the power of prob_bits.
+ * @param[in] prob_bits The number of bits used to describe probabilities.
+ * @param[out] freqs Array of size quantized frequencies.
+ * @param[out] cdf Array of size+1 cumulative frequencies, starting with 0.
+ */
+void rANSQuantizePdf(const float* pdf, size_t size, uint32_t prob_bits, uint32_t* freqs, uint32_t* cdf);
+
+#endif //CLIONSCRATCHPAD_RANSQUANTIZE_H
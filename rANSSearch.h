@@ -0,0 +1,72 @@
+//
+// Symbol search over a quantized cdf.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSSEARCH_H
+#define CLIONSCRATCHPAD_RANSSEARCH_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__AVX2__) || defined(__SSE2__))
+#define RANS_SEARCH_SIMD
+#include <immintrin.h>
+#endif
+
+// Below this many remaining entries the search switches from bisection to a linear vector scan.
+#define RANS_SEARCH_WINDOW 16
+
+/**
+ * @brief Returns the symbol whose bucket in cdf contains the cumulative frequency cum_prob.
+ *
+ * @details cdf has size+1 entries, starting with 0 and non-decreasing. The result is the first symbol s with
+ * cdf[s+1] > cum_prob, which is what the linear scan in the decoder used to find for every valid stream.
+ *
+ * Large alphabets are first narrowed down with a branchless bisection, the remaining window is then scanned with
+ * AVX2 (8 entries per compare) or SSE2 (4 entries per compare), using compare-and-movemask. Without either instruction
+ * set a scalar scan is used. All variants return the same symbol.
+ *
+ * The comparisons are signed, so the cdf values must stay below 2 to the power of 31.
+ *
+ * @param[in] cdf Cumulative frequencies, size+1 entries.
+ * @param[in] size Size of the alphabet.
+ * @param[in] cum_prob Cumulative frequency as returned by Rans64DecGet.
+ * @return The decoded symbol.
+ */
+static inline uint32_t rANSFindSymbol(const uint32_t* cdf, size_t size, uint32_t cum_prob)
+{
+    // find the first entry > cum_prob in cdf[1..size-1]
+    const uint32_t* base = cdf + 1;
+    size_t len = size - 1;
+
+    while (len > RANS_SEARCH_WINDOW) {
+        size_t half = len / 2;
+        base = (base[half] <= cum_prob) ? base + half : base;
+        len -= half;
+    }
+
+    size_t i = 0;
+#if defined(RANS_SEARCH_SIMD) && defined(__AVX2__)
+    __m256i c8 = _mm256_set1_epi32((int32_t) cum_prob);
+    for (; i + 8 <= len; i += 8) {
+        __m256i gt = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*) (base + i)), c8);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(gt));
+        if (mask) return (uint32_t) (base - cdf - 1 + i + __builtin_ctz(mask));
+    }
+#endif
+#if defined(RANS_SEARCH_SIMD)
+    __m128i c4 = _mm_set1_epi32((int32_t) cum_prob);
+    for (; i + 4 <= len; i += 4) {
+        __m128i gt = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*) (base + i)), c4);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(gt));
+        if (mask) return (uint32_t) (base - cdf - 1 + i + __builtin_ctz(mask));
+    }
+#endif
+    for (; i < len; i++) {
+        if (base[i] > cum_prob) break;
+    }
+
+    return (uint32_t) (base - cdf - 1 + i);
+}
+
+#endif //CLIONSCRATCHPAD_RANSSEARCH_H
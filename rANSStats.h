@@ -0,0 +1,53 @@
+//
+// Optional counters of the rANS coder, compiled in with RANS_STATS.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSSTATS_H
+#define CLIONSCRATCHPAD_RANSSTATS_H
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Keeps its arguments only in builds with RANS_STATS defined, so the counting costs nothing otherwise.
+#ifdef RANS_STATS
+#define RANS_STATS_ONLY(...) __VA_ARGS__
+#else
+#define RANS_STATS_ONLY(...)
+#endif
+
+/**
+ * @brief Counters of a rANSCoder, telling where the bits and the time go.
+ *
+ * @details The ideal cost is the Shannon cost of the symbols under the distributions passed to the coder, the model
+ * cost the one under the quantized frequencies it actually codes with. Their difference is the quantization loss. The
+ * bits written are 32 bits per renormalization word, which leaves out the 64 bits of the final state of every message;
+ * the difference to the model cost is the overhead of the coder itself.
+ *
+ * All counters stay 0 unless the library is built with RANS_STATS.
+ */
+typedef struct {
+    uint64_t symbols;           // Symbols encoded or decoded.
+    uint64_t words;             // Renormalization words written or read.
+    double ideal_bits;          // Shannon cost under the given distributions, symbols of probability 0 left out.
+    double model_bits;          // Shannon cost under the quantized frequencies.
+    uint64_t clamped;           // Symbols whose probability quantized to 0 and was raised to the smallest frequency.
+    uint64_t quantize_cycles;   // Time spent quantizing pdfs.
+    uint64_t coding_cycles;     // Time spent coding, without the quantization.
+} rANSStats;
+
+// Time stamp the cycle counters are measured with: the time stamp counter on x86, nanoseconds elsewhere.
+static inline uint64_t rANSStatsClock() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __rdtsc();
+#else
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#endif //CLIONSCRATCHPAD_RANSSTATS_H
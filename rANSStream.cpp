@@ -0,0 +1,157 @@
+//
+// Streaming encoder and decoder with bounded memory, writing frames to std::ostream.
+//
+
+#include "rANSStream.h"
+#include <algorithm>
+#include <iostream>
+
+rANSStreamEncoder::rANSStreamEncoder(std::ostream& os, const rANSModel& model, size_t window_size)
+        : os(os), model(model), coder(1 << 11, model.get_prob_bits()), window_size(window_size) {
+    if (this->window_size == 0 || this->window_size > RANS_STREAM_MAX_WINDOW) {
+        std::cout << "ERROR: Stream window must hold 1 to " << RANS_STREAM_MAX_WINDOW << " symbols." << std::endl;
+        this->window_size = std::min(std::max(this->window_size, (size_t) 1), (size_t) RANS_STREAM_MAX_WINDOW);
+    }
+    window.reserve(this->window_size);
+}
+
+rANSStreamEncoder::~rANSStreamEncoder() {
+    if (!finished) finish();
+}
+
+bool rANSStreamEncoder::write_words(const uint32_t* words, size_t n) {
+    os.write((const char*) words, n * sizeof(uint32_t));
+    if (!os) {
+        std::cout << "ERROR: Writing the stream failed." << std::endl;
+        return false;
+    }
+    num_bytes += n * sizeof(uint32_t);
+    return true;
+}
+
+bool rANSStreamEncoder::write_frame(const uint32_t* syms, size_t n) {
+    coder.encode_batch(syms, n, model);
+    std::vector<uint32_t> payload = coder.release_buffer();
+
+    uint32_t header[RANS_STREAM_FRAME_WORDS] = {RANS_FORMAT_MARKER(RANS_FORMAT_STREAM, RANS_STREAM_VERSION),
+                                                (uint32_t) n, (uint32_t) payload.size()};
+    return write_words(header, RANS_STREAM_FRAME_WORDS) && write_words(payload.data(), payload.size());
+}
+
+bool rANSStreamEncoder::write(const uint32_t* syms, size_t n) {
+    if (finished) {
+        std::cout << "ERROR: Writing to a finished stream." << std::endl;
+        return false;
+    }
+
+    // a frame with a bad symbol would not decode, so refuse the whole call before anything is written
+    const uint32_t* freqs = model.get_freqs();
+    for (size_t i = 0; i < n; i++) {
+        if (syms[i] >= model.size() || freqs[syms[i]] == 0) {
+            std::cout << "ERROR: Symbol " << i << " has a frequency of 0 in the model." << std::endl;
+            return false;
+        }
+    }
+    num_symbols += n;
+
+    while (n > 0) {
+        // full windows are encoded straight from the input, without going through the window buffer
+        if (window.empty() && n >= window_size) {
+            if (!write_frame(syms, window_size)) return false;
+            syms += window_size;
+            n -= window_size;
+            continue;
+        }
+
+        size_t take = std::min(n, window_size - window.size());
+        window.insert(window.end(), syms, syms + take);
+        syms += take;
+        n -= take;
+        if (window.size() == window_size) {
+            if (!write_frame(window.data(), window.size())) return false;
+            window.clear();
+        }
+    }
+    return true;
+}
+
+bool rANSStreamEncoder::flush() {
+    if (!window.empty()) {
+        if (!write_frame(window.data(), window.size())) return false;
+        window.clear();
+    }
+    os.flush();
+    return (bool) os;
+}
+
+bool rANSStreamEncoder::finish() {
+    if (finished) return true;
+    finished = true;
+
+    uint32_t end[RANS_STREAM_FRAME_WORDS] = {RANS_FORMAT_MARKER(RANS_FORMAT_STREAM, RANS_STREAM_VERSION), 0, 0};
+    bool ok = flush() && write_words(end, RANS_STREAM_FRAME_WORDS);
+    os.flush();
+    return ok && os;
+}
+
+rANSStreamDecoder::rANSStreamDecoder(std::istream& is, const rANSModel& model)
+        : is(is), model(model), coder(1 << 11, model.get_prob_bits()) {
+}
+
+bool rANSStreamDecoder::next_frame() {
+    uint32_t header[RANS_STREAM_FRAME_WORDS];
+    is.read((char*) header, sizeof(header));
+    if (!is) {
+        std::cout << "ERROR: Stream ends without its closing frame." << std::endl;
+        return false;
+    }
+
+    // a frame writes at most one word per symbol plus the final state
+    size_t symbols = header[1];
+    size_t words = header[2];
+    if (header[0] != RANS_FORMAT_MARKER(RANS_FORMAT_STREAM, RANS_STREAM_VERSION) || symbols > RANS_STREAM_MAX_WINDOW ||
+        words > symbols + 2 || (symbols > 0 && words < 2) || (symbols == 0 && words > 0)) {
+        std::cout << "ERROR: Stream frame header is malformed." << std::endl;
+        return false;
+    }
+    if (symbols == 0) {
+        ended = true;
+        return true;
+    }
+
+    frame.resize(words);
+    is.read((char*) frame.data(), words * sizeof(uint32_t));
+    if (!is) {
+        std::cout << "ERROR: Stream frame is truncated." << std::endl;
+        return false;
+    }
+    coder.init_dc_view(frame.data(), frame.size());
+    frame_left = symbols;
+    return true;
+}
+
+size_t rANSStreamDecoder::read(uint32_t* out, size_t n) {
+    size_t done = 0;
+    while (done < n && !failed) {
+        if (frame_left == 0) {
+            if (ended) break;
+            if (!next_frame()) {
+                failed = true;
+                break;
+            }
+            continue;
+        }
+
+        // the coder never reads before the frame, and a frame decoded right ends exactly at its start
+        size_t take = std::min(n - done, frame_left);
+        coder.decode_batch(model, take, out + done);
+        if (coder.decode_failed() || (take == frame_left && coder.words_left() != 0)) {
+            std::cout << "ERROR: Stream frame is corrupt." << std::endl;
+            failed = true;
+            break;
+        }
+        frame_left -= take;
+        done += take;
+    }
+    return done;
+}
@@ -0,0 +1,167 @@
+//
+// Streaming encoder and decoder with bounded memory, writing frames to std::ostream.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSSTREAM_H
+#define CLIONSCRATCHPAD_RANSSTREAM_H
+
+#include "rANSCoder.h"
+#include "rANSModel.h"
+#include "rANSFormat.h"
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <cstddef>
+
+// Default number of symbols per frame. The window and the encoded frame take about 1 MiB each.
+#define RANS_STREAM_WINDOW (1 << 18)
+
+// Largest number of symbols per frame, so that a corrupt frame header cannot make the decoder allocate without bound.
+#define RANS_STREAM_MAX_WINDOW (1 << 26)
+
+/**
+ * @brief Encodes an unbounded sequence of symbols with a static model into a std::ostream, using bounded memory.
+ *
+ * @details rANS encodes backwards, so the rANSCoder has to hold the whole text before the first symbol can be
+ * decoded. This encoder collects the symbols in a window of window_size symbols and encodes every full window to
+ * completion as an independent frame, which is written out right away. Memory stays at the window plus one encoded
+ * frame, whatever the length of the input. Every frame costs its final state and a header, 5 words in all.
+ *
+ * The stream is a sequence of frames, closed by an empty one:
+ *
+ *     marker word (RANS_FORMAT_STREAM, version)
+ *     number of symbols in the frame
+ *     number of payload words
+ *     payload, the frame as encoded by rANSCoder::encode_batch
+ *
+ * Words are written in host byte order.
+ *
+ * Example usage:
+ *
+ *     std::ofstream file("symbols.rans", std::ios::binary);
+ *     rANSStreamEncoder encoder(file, model);
+ *     while (size_t n = next_chunk(chunk)) {
+ *         encoder.write(chunk, n);
+ *     }
+ *     encoder.finish();
+ */
+class rANSStreamEncoder {
+
+private:
+
+    std::ostream& os;
+    rANSModel model;
+    rANSCoder coder;
+    std::vector<uint32_t> window;
+    size_t window_size;
+    uint64_t num_symbols = 0;
+    uint64_t num_bytes = 0;
+    bool finished = false;
+
+    bool write_words(const uint32_t* words, size_t n);
+    bool write_frame(const uint32_t* syms, size_t n);
+
+public:
+
+    /**
+     * @brief Starts a stream.
+     *
+     * @param[in] os Stream receiving the frames, opened in binary mode. Must outlive the encoder.
+     * @param[in] model Model to encode with, copied.
+     * @param[in] window_size Number of symbols per frame, at most RANS_STREAM_MAX_WINDOW.
+     */
+    rANSStreamEncoder(std::ostream& os, const rANSModel& model, size_t window_size = RANS_STREAM_WINDOW);
+
+    /**
+     * @brief Finishes the stream if finish was not called.
+     */
+    ~rANSStreamEncoder();
+
+    /**
+     * @brief Appends symbols to the stream, writing a frame for every window that fills up.
+     *
+     * @param[in] syms Array of n symbols to encode, all with a frequency above 0 in the model.
+     * @param[in] n Number of symbols.
+     * @return false if a symbol is not in the model, in which case nothing is appended, or if writing failed.
+     */
+    bool write(const uint32_t* syms, size_t n);
+
+    /**
+     * @brief Writes the symbols collected so far as a frame, even if the window is not full, and flushes the stream.
+     *
+     * @return false if writing failed.
+     */
+    bool flush();
+
+    /**
+     * @brief Writes the remaining symbols and the closing frame. Nothing can be written afterwards.
+     *
+     * @return false if writing failed.
+     */
+    bool finish();
+
+    uint64_t get_num_symbols() const { return num_symbols; }
+    uint64_t get_num_bytes() const { return num_bytes; }
+
+};
+
+/**
+ * @brief Decodes a stream written by rANSStreamEncoder frame by frame, using bounded memory.
+ *
+ * @details Only the frame being decoded is held in memory. Symbols are returned in their original order, in reads of
+ * any size that do not need to line up with the frames.
+ *
+ * Example usage:
+ *
+ *     std::ifstream file("symbols.rans", std::ios::binary);
+ *     rANSStreamDecoder decoder(file, model);
+ *     while (size_t n = decoder.read(chunk, chunk_size)) {
+ *         consume(chunk, n);
+ *     }
+ */
+class rANSStreamDecoder {
+
+private:
+
+    std::istream& is;
+    rANSModel model;
+    rANSCoder coder;
+    std::vector<uint32_t> frame;
+    size_t frame_left = 0;
+    bool ended = false;
+    bool failed = false;
+
+    bool next_frame();
+
+public:
+
+    /**
+     * @brief Starts decoding a stream.
+     *
+     * @param[in] is Stream holding the frames, opened in binary mode. Must outlive the decoder.
+     * @param[in] model Model to decode with, copied - must correspond exactly to the model used to encode.
+     */
+    rANSStreamDecoder(std::istream& is, const rANSModel& model);
+
+    /**
+     * @brief Decodes up to n symbols, reading frames from the stream as needed.
+     *
+     * @param[out] out Preallocated array of n symbols receiving the decoded text.
+     * @param[in] n Number of symbols to decode.
+     * @return The number of symbols decoded, less than n only at the end of the stream or on an error.
+     */
+    size_t read(uint32_t* out, size_t n);
+
+    /**
+     * @brief Returns true once the closing frame was read and all symbols are decoded.
+     */
+    bool eof() const { return ended && frame_left == 0; }
+
+    /**
+     * @brief Returns true if the stream is malformed or truncated, or a frame does not decode to exactly its words.
+     */
+    bool fail() const { return failed; }
+
+};
+
+#endif //CLIONSCRATCHPAD_RANSSTREAM_H
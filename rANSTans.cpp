@@ -0,0 +1,165 @@
+//
+// Table-driven ANS (tANS / FSE) backend for static models.
+//
+
+#include "rANSTans.h"
+#include <iostream>
+
+// Number of interleaved states sharing the bit stream.
+#define RANS_TANS_STATES 2
+
+// Position step of the state spreading, the one of FSE. It is odd for tables of at least RANS_TANS_MIN_BITS, so it
+// visits every state of them.
+#define RANS_TANS_STEP(size) (((size) >> 1) + ((size) >> 3) + 3)
+
+static inline uint32_t highbit(uint32_t v) {
+    return 31 - __builtin_clz(v);
+}
+
+rANSTansTable::rANSTansTable(const rANSModel& model) : prob_bits(model.get_prob_bits()) {
+    if (prob_bits < RANS_TANS_MIN_BITS || prob_bits > RANS_TANS_MAX_BITS) {
+        std::cout << "ERROR: tANS tables support " << RANS_TANS_MIN_BITS << " to " << RANS_TANS_MAX_BITS
+                  << " prob_bits." << std::endl;
+        return;
+    }
+
+    const uint32_t table_size = 1u << prob_bits;
+    const uint32_t mask = table_size - 1;
+    const size_t alphabet = model.size();
+    freqs.assign(model.get_freqs(), model.get_freqs() + alphabet);
+
+    // spread the states over the symbols, symbol s gets freqs[s] of them
+    std::vector<uint32_t> spread(table_size);
+    uint32_t pos = 0;
+    for (size_t s = 0; s < alphabet; s++) {
+        for (uint32_t i = 0; i < freqs[s]; i++) {
+            spread[pos] = (uint32_t) s;
+            pos = (pos + RANS_TANS_STEP(table_size)) & mask;
+        }
+    }
+
+    // encoder: the states of every symbol in increasing order, starting at its cumulative frequency
+    states.resize(table_size);
+    std::vector<uint32_t> next(model.get_cdf(), model.get_cdf() + alphabet);
+    for (uint32_t u = 0; u < table_size; u++) {
+        states[next[spread[u]]++] = table_size + u;
+    }
+
+    enc_syms.resize(alphabet);
+    const uint32_t* cdf = model.get_cdf();
+    for (size_t s = 0; s < alphabet; s++) {
+        uint32_t f = freqs[s];
+        if (f == 0) {
+            enc_syms[s].delta_bits = 0;
+            enc_syms[s].delta_state = 0;
+        } else if (f == 1) {
+            enc_syms[s].delta_bits = (prob_bits << 16) - table_size;
+            enc_syms[s].delta_state = (int32_t) cdf[s] - 1;
+        } else {
+            uint32_t max_bits = prob_bits - highbit(f - 1);
+            enc_syms[s].delta_bits = (max_bits << 16) - (f << max_bits);
+            enc_syms[s].delta_state = (int32_t) cdf[s] - (int32_t) f;
+        }
+    }
+
+    // decoder: state u yields spread[u], the next state is rebuilt from the bits the encoder shifted out
+    dec_table.resize(table_size);
+    std::vector<uint32_t> next_state(freqs);
+    for (uint32_t u = 0; u < table_size; u++) {
+        uint32_t s = spread[u];
+        uint32_t x = next_state[s]++;
+        uint32_t bits = prob_bits - highbit(x);
+        dec_table[u].sym = s;
+        dec_table[u].bits = (uint16_t) bits;
+        dec_table[u].base = (uint16_t) ((x << bits) - table_size);
+    }
+}
+
+// Appends count bits of value to the bit stream in acc/fill, moving whole words to out.
+static inline void put_bits(std::vector<uint32_t>& out, uint64_t& acc, uint32_t& fill, uint32_t value, uint32_t count) {
+    acc |= (uint64_t) value << fill;
+    fill += count;
+    if (fill >= 32) {
+        out.push_back((uint32_t) acc);
+        acc >>= 32;
+        fill -= 32;
+    }
+}
+
+void rANSTansEncode(const uint32_t* syms, size_t n, const rANSTansTable& table, std::vector<uint32_t>& out) {
+    const uint32_t prob_bits = table.get_prob_bits();
+    const uint32_t table_size = 1u << prob_bits;
+    const uint32_t* states = table.get_states();
+    const rANSTansEncSymbol* enc_syms = table.get_enc_symbols();
+
+    size_t header = out.size();
+    out.push_back(RANS_FORMAT_MARKER(RANS_FORMAT_TANS, prob_bits));
+    out.push_back(0);
+    out.push_back(0);
+
+    uint64_t acc = 0;
+    uint32_t fill = 0;
+    uint32_t x[RANS_TANS_STATES] = {table_size, table_size};
+    for (size_t i = n; i > 0; i--) {
+        uint32_t& xi = x[(i-1) % RANS_TANS_STATES];
+        const rANSTansEncSymbol& e = enc_syms[syms[i-1]];
+        uint32_t bits = (xi + e.delta_bits) >> 16;
+        put_bits(out, acc, fill, xi & ((1u << bits) - 1), bits);
+        xi = states[(xi >> bits) + e.delta_state];
+    }
+
+    // the final states go last, the decoder reads them first
+    for (size_t k = RANS_TANS_STATES; k > 0; k--) {
+        put_bits(out, acc, fill, x[k-1] - table_size, prob_bits);
+    }
+    uint64_t total = (uint64_t) (out.size() - header - RANS_TANS_HEADER_WORDS) * 32 + fill;
+    if (fill > 0) out.push_back((uint32_t) acc);
+    out.push_back(0);
+
+    out[header + 1] = (uint32_t) total;
+    out[header + 2] = (uint32_t) (total >> 32);
+}
+
+bool rANSTansDecode(const uint32_t* data, size_t size, const rANSTansTable& table, size_t n, uint32_t* out) {
+    const uint32_t prob_bits = table.get_prob_bits();
+    if (table.size() == 0 || size < RANS_TANS_HEADER_WORDS + 1 || data[0] != RANS_FORMAT_MARKER(RANS_FORMAT_TANS, prob_bits)) return false;
+
+    uint64_t pos = (uint64_t) data[1] | (uint64_t) data[2] << 32;
+    const uint32_t* words = data + RANS_TANS_HEADER_WORDS;
+    // every bit must be inside the payload, which is followed by the padding word
+    if (pos < RANS_TANS_STATES * prob_bits || (pos + 31) / 32 + 1 > size - RANS_TANS_HEADER_WORDS) return false;
+
+    const rANSTansDecEntry* dec_table = table.get_dec_table();
+
+    // reads the count bits ending at bit pos
+    #define RANS_TANS_READ(count) \
+        (pos -= (count), \
+         (uint32_t) ((((uint64_t) words[pos >> 5] | (uint64_t) words[(pos >> 5) + 1] << 32) >> (pos & 31)) \
+                     & ((1u << (count)) - 1)))
+
+    uint32_t s0 = RANS_TANS_READ(prob_bits);
+    uint32_t s1 = RANS_TANS_READ(prob_bits);
+
+    // the two states alternate, so the table lookup of one overlaps the bit read of the other
+    size_t i = 0;
+    for (; i + 1 < n; i += 2) {
+        const rANSTansDecEntry& e0 = dec_table[s0];
+        const rANSTansDecEntry& e1 = dec_table[s1];
+        out[i] = e0.sym;
+        out[i+1] = e1.sym;
+        if ((uint64_t) e0.bits + e1.bits > pos) return false;
+        s0 = e0.base + RANS_TANS_READ(e0.bits);
+        s1 = e1.base + RANS_TANS_READ(e1.bits);
+    }
+    if (i < n) {
+        const rANSTansDecEntry& e0 = dec_table[s0];
+        out[i] = e0.sym;
+        if (e0.bits > pos) return false;
+        s0 = e0.base + RANS_TANS_READ(e0.bits);
+    }
+
+    #undef RANS_TANS_READ
+
+    // the encoder started from states 0 with no bits written
+    return pos == 0 && s0 == 0 && s1 == 0;
+}
@@ -0,0 +1,113 @@
+//
+// Table-driven ANS (tANS / FSE) backend for static models.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSTANS_H
+#define CLIONSCRATCHPAD_RANSTANS_H
+
+#include "rANSModel.h"
+#include "rANSFormat.h"
+#include <vector>
+#include <cstddef>
+
+// Largest prob_bits of a tANS table. The decoder table has 2 to the power of prob_bits entries of 8 bytes, so at 16
+// bits it takes 512 KiB and at the default of 14 bits 128 KiB.
+#define RANS_TANS_MAX_BITS 16
+
+// Smallest prob_bits of a tANS table, the smallest table log of FSE. Below it the spreading step is not odd for every
+// table size and leaves states unvisited.
+#define RANS_TANS_MIN_BITS 5
+
+// Decoder table entry: the symbol of a state, and how to reach the next state from the bits read after it.
+typedef struct {
+    uint32_t sym;       // Symbol.
+    uint16_t base;      // Next state before adding the bits read.
+    uint16_t bits;      // Number of bits to read.
+} rANSTansDecEntry;
+
+// Encoder transform of a symbol, as in FSE.
+typedef struct {
+    uint32_t delta_bits;    // Added to the state, the upper 16 bits are the number of bits to write.
+    int32_t delta_state;    // Added to the state after shifting out the bits, indexes the state table.
+} rANSTansEncSymbol;
+
+/**
+ * @brief The encoder and decoder tables of a tANS coder for a static model.
+ *
+ * @details tANS, the finite state entropy coder of FSE, works on a state in [0, 2 to the power of prob_bits) and
+ * replaces the arithmetic of rANS by tables. The states are spread over the symbols in proportion to the model's
+ * quantized frequencies, with the FSE spreading step, so the compression matches a rANS coder with the same model up
+ * to the approximation of the spreading.
+ *
+ * Decoding a symbol is one table lookup giving the symbol and the next state base, plus a read of a few bits, with no
+ * multiplication. Encoding shifts out bits and looks up the next state.
+ *
+ * Example usage:
+ *
+ *     rANSModel model(counts);
+ *     rANSTansTable table(model);
+ *
+ *     rANSCoder coder;
+ *     auto encoded = coder.encode_tans(syms, n, table);
+ *     coder.decode_tans(encoded.data(), encoded.size(), table, n, out);
+ */
+class rANSTansTable {
+
+private:
+
+    uint32_t prob_bits;
+    std::vector<uint32_t> freqs;
+    std::vector<uint32_t> states;
+    std::vector<rANSTansEncSymbol> enc_syms;
+    std::vector<rANSTansDecEntry> dec_table;
+
+public:
+
+    /**
+     * @brief Builds the tables from the quantized frequencies of a model.
+     *
+     * @param[in] model Model to build from, with RANS_TANS_MIN_BITS to RANS_TANS_MAX_BITS prob_bits. The table is
+     * left empty otherwise.
+     */
+    explicit rANSTansTable(const rANSModel& model);
+
+    uint32_t get_prob_bits() const { return prob_bits; }
+    size_t size() const { return freqs.size(); }
+    const uint32_t* get_freqs() const { return freqs.data(); }
+    const uint32_t* get_states() const { return states.data(); }
+    const rANSTansEncSymbol* get_enc_symbols() const { return enc_syms.data(); }
+    const rANSTansDecEntry* get_dec_table() const { return dec_table.data(); }
+
+};
+
+/**
+ * @brief Encodes an array of symbols with a tANS table.
+ *
+ * @details The symbols are encoded backwards into a bit stream the decoder reads from its end. Two states take turns,
+ * symbol i uses state i % 2, so that the decoder can overlap the table lookups of both. The stream layout is
+ *
+ *     marker word (RANS_FORMAT_TANS, prob_bits)
+ *     number of payload bits (2 words)
+ *     payload, bits packed from the least significant bit of each word on, ending with the final states
+ *     one padding word
+ *
+ * @param[in] syms Array of n symbols to encode, all with a frequency above 0.
+ * @param[in] n Number of symbols.
+ * @param[in] table Table to encode with.
+ * @param[out] out Receives the encoded stream.
+ */
+void rANSTansEncode(const uint32_t* syms, size_t n, const rANSTansTable& table, std::vector<uint32_t>& out);
+
+/**
+ * @brief Decodes a stream produced by rANSTansEncode.
+ *
+ * @param[in] data The encoded stream.
+ * @param[in] size Size of the stream in words.
+ * @param[in] table Table to decode with - must be built from the model used to encode.
+ * @param[in] n Number of symbols to decode.
+ * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+ * @return false if the stream is malformed or was not consumed exactly, or the table is empty.
+ */
+bool rANSTansDecode(const uint32_t* data, size_t size, const rANSTansTable& table, size_t n, uint32_t* out);
+
+#endif //CLIONSCRATCHPAD_RANSTANS_H
@@ -0,0 +1,77 @@
+//
+// Fixed-size thread pool for the block-parallel coder.
+//
+
+#include "rANSThreadPool.h"
+
+rANSThreadPool::rANSThreadPool(unsigned threads) : next(0) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&rANSThreadPool::worker_loop, this);
+    }
+}
+
+rANSThreadPool::~rANSThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+void rANSThreadPool::run_job() {
+    size_t i;
+    while ((i = next.fetch_add(1)) < job_count) {
+        (*job)(i);
+    }
+}
+
+void rANSThreadPool::worker_loop() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+        }
+
+        run_job();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void rANSThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& fn) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> serialize(busy);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        job_count = count;
+        next = 0;
+        active = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    run_job();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return active == 0; });
+    job = nullptr;
+}
@@ -0,0 +1,77 @@
+//
+// Fixed-size thread pool for the block-parallel coder.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSTHREADPOOL_H
+#define CLIONSCRATCHPAD_RANSTHREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads running parallel loops.
+ *
+ * @details The threads are started once and sleep between jobs, so coding many small arrays does not pay for thread
+ * creation every time. A pool of size n runs a loop on n-1 workers plus the calling thread.
+ *
+ * Example usage:
+ *
+ *     rANSThreadPool pool(4);
+ *     pool.parallel_for(blocks, [&](size_t b) { encode_block(b); });
+ */
+class rANSThreadPool {
+
+private:
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex busy;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t job_count = 0;
+    std::atomic<size_t> next;
+    size_t active = 0;
+    uint64_t generation = 0;
+    bool stop = false;
+
+    void worker_loop();
+    void run_job();
+
+public:
+
+    /**
+     * @brief Starts the pool.
+     *
+     * @param[in] threads Number of threads taking part in a loop, including the caller. 0 means one per core.
+     */
+    explicit rANSThreadPool(unsigned threads);
+
+    ~rANSThreadPool();
+
+    rANSThreadPool(const rANSThreadPool&) = delete;
+    rANSThreadPool& operator=(const rANSThreadPool&) = delete;
+
+    /**
+     * @brief Number of threads taking part in a loop, including the caller.
+     */
+    unsigned size() const { return (unsigned) workers.size() + 1; }
+
+    /**
+     * @brief Calls fn(i) for every i in [0, count) and returns when all calls are done.
+     *
+     * @details The indices are handed out one at a time, so uneven work items balance out. Calls from several
+     * threads at once are serialized.
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+
+};
+
+
+#endif //CLIONSCRATCHPAD_RANSTHREADPOOL_H
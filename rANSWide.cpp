@@ -0,0 +1,259 @@
+//
+// Wide-lane rANS kernel for static models.
+//
+
+#include "rANSWide.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__AVX2__) || defined(__AVX512F__))
+#include <immintrin.h>
+#endif
+
+// Encodes a symbol into a 32-bit lane state, emitting at most one 16-bit word.
+static inline void wide_put(uint32_t* r, std::vector<uint16_t>& words, uint32_t start, uint32_t freq, uint32_t scale_bits)
+{
+    uint32_t x = *r;
+    uint64_t x_max = ((uint64_t) (RANS_WIDE_L >> scale_bits) << 16) * freq;
+    if (x >= x_max) {
+        words.push_back((uint16_t) x);
+        x >>= 16;
+    }
+
+    *r = ((x / freq) << scale_bits) + (x % freq) + start;
+}
+
+// Decodes a symbol from a 32-bit lane state into *sym, reading backwards from *pptr. Returns false instead of reading
+// below begin.
+static inline bool wide_get(uint32_t* r, const uint16_t** pptr, const uint16_t* begin, const rANSDecSlot* slots,
+                            uint32_t scale_bits, uint32_t* sym)
+{
+    uint32_t x = *r;
+    uint32_t slot = x & ((1u << scale_bits) - 1);
+    const rANSDecSlot& e = slots[slot];
+
+    x = e.freq * (x >> scale_bits) + slot - e.start;
+    if (x < RANS_WIDE_L) {
+        if (*pptr == begin) return false;
+        *pptr -= 1;
+        x = (x << 16) | **pptr;
+    }
+
+    *r = x;
+    *sym = e.sym;
+    return true;
+}
+
+template <uint32_t LANES>
+static void wide_encode(uint32_t* states, std::vector<uint16_t>& words, const uint32_t* syms, size_t n,
+                        const rANSModel& model)
+{
+    const uint32_t prob_bits = model.get_prob_bits();
+    const uint32_t* cdf = model.get_cdf();
+    const uint32_t* freqs = model.get_freqs();
+
+    // backwards, so the decoder runs forwards and meets the words of a step in lane order
+    size_t full = n - n % LANES;
+    for (size_t i = n; i-- > full;) {
+        wide_put(&states[i - full], words, cdf[syms[i]], freqs[syms[i]], prob_bits);
+    }
+    for (size_t i = full; i > 0; i -= LANES) {
+        for (uint32_t k = LANES; k-- > 0;) {
+            uint32_t s = syms[i - LANES + k];
+            wide_put(&states[k], words, cdf[s], freqs[s], prob_bits);
+        }
+    }
+}
+
+void rANSWideEncode(const uint32_t* syms, size_t n, const rANSModel& model, uint32_t lanes, std::vector<uint32_t>& out)
+{
+    uint32_t states[16];
+    for (uint32_t k = 0; k < lanes; k++) {
+        states[k] = RANS_WIDE_L;
+    }
+
+    std::vector<uint16_t> words;
+    words.reserve(n / 2 + 16);
+    if (lanes == 16) {
+        wide_encode<16>(states, words, syms, n, model);
+    } else {
+        wide_encode<8>(states, words, syms, n, model);
+    }
+
+    out.push_back(RANS_FORMAT_MARKER(RANS_FORMAT_WIDE, lanes));
+    out.push_back((uint32_t) words.size());
+    out.insert(out.end(), states, states + lanes);
+
+    size_t payload = out.size();
+    out.resize(payload + (words.size() + 1) / 2, 0);
+    memcpy(out.data() + payload, words.data(), words.size() * sizeof(uint16_t));
+}
+
+// Scalar decoder for full steps, also used near the start of the payload where the vector loads would overrun it.
+template <uint32_t LANES>
+static bool wide_decode_scalar(uint32_t* states, const uint16_t** pptr, const uint16_t* begin,
+                               const rANSDecSlot* slots, uint32_t prob_bits, size_t i, size_t full, uint32_t* out)
+{
+    for (; i < full; i += LANES) {
+        for (uint32_t k = 0; k < LANES; k++) {
+            if (!wide_get(&states[k], pptr, begin, slots, prob_bits, out + i + k)) return false;
+        }
+    }
+    return true;
+}
+
+#if defined(__GNUC__) && defined(__AVX2__)
+
+// For every renormalization mask, the source element of each lane: lane j takes the (rank of j in mask)-th word
+// below the cursor. The words are loaded as the 8 words below the cursor, so that is element 7 - rank.
+struct WidePermTable {
+    uint32_t idx[256][8] __attribute__((aligned(32)));
+
+    WidePermTable() {
+        for (uint32_t m = 0; m < 256; m++) {
+            uint32_t rank = 0;
+            for (uint32_t j = 0; j < 8; j++) {
+                idx[m][j] = 0;
+                if (m & (1u << j)) {
+                    idx[m][j] = 7 - rank;
+                    rank++;
+                }
+            }
+        }
+    }
+};
+
+static const WidePermTable wide_perm_table;
+
+// Decodes full steps of 8 lanes with AVX2. Returns the index of the first symbol not decoded.
+static size_t wide_decode_avx2(uint32_t* states, const uint16_t** pptr, const uint16_t* begin,
+                               const rANSDecSlot* slots, uint32_t prob_bits, size_t i, size_t full, uint32_t* out)
+{
+    const int* base = (const int*) slots;
+    const __m256i mask = _mm256_set1_epi32((1 << prob_bits) - 1);
+    const __m256i low16 = _mm256_set1_epi32(0xffff);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m128i shift = _mm_cvtsi32_si128(prob_bits);
+    const uint16_t* ptr = *pptr;
+
+    __m256i x = _mm256_loadu_si256((const __m256i*) states);
+    for (; i < full && ptr - begin >= 8; i += 8) {
+        __m256i slot = _mm256_and_si256(x, mask);
+        __m256i freq_start = _mm256_i32gather_epi32(base, slot, 8);
+        __m256i sym = _mm256_i32gather_epi32(base + 1, slot, 8);
+        __m256i freq = _mm256_and_si256(freq_start, low16);
+        __m256i start = _mm256_srli_epi32(freq_start, 16);
+
+        // x = freq * (x >> prob_bits) + slot - start
+        x = _mm256_add_epi32(_mm256_mullo_epi32(freq, _mm256_srl_epi32(x, shift)), _mm256_sub_epi32(slot, start));
+        _mm256_storeu_si256((__m256i*) (out + i), sym);
+
+        // renormalize the lanes below L
+        __m256i need = _mm256_cmpeq_epi32(_mm256_srli_epi32(x, 16), zero);
+        int m = _mm256_movemask_ps(_mm256_castsi256_ps(need));
+        if (m) {
+            __m256i words = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (ptr - 8)));
+            __m256i perm = _mm256_load_si256((const __m256i*) wide_perm_table.idx[m]);
+            __m256i renorm = _mm256_or_si256(_mm256_slli_epi32(x, 16), _mm256_permutevar8x32_epi32(words, perm));
+            x = _mm256_blendv_epi8(x, renorm, need);
+            ptr -= __builtin_popcount(m);
+        }
+    }
+    _mm256_storeu_si256((__m256i*) states, x);
+
+    *pptr = ptr;
+    return i;
+}
+
+#endif
+
+#if defined(__GNUC__) && defined(__AVX512F__)
+
+// Decodes full steps of 16 lanes with AVX-512. Returns the index of the first symbol not decoded.
+static size_t wide_decode_avx512(uint32_t* states, const uint16_t** pptr, const uint16_t* begin,
+                                 const rANSDecSlot* slots, uint32_t prob_bits, size_t i, size_t full, uint32_t* out)
+{
+    const int* base = (const int*) slots;
+    const __m512i mask = _mm512_set1_epi32((1 << prob_bits) - 1);
+    const __m512i low16 = _mm512_set1_epi32(0xffff);
+    const __m512i lower_bound = _mm512_set1_epi32(RANS_WIDE_L);
+    const __m512i reverse = _mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i shift = _mm_cvtsi32_si128(prob_bits);
+    const uint16_t* ptr = *pptr;
+
+    __m512i x = _mm512_loadu_si512(states);
+    for (; i < full && ptr - begin >= 16; i += 16) {
+        __m512i slot = _mm512_and_si512(x, mask);
+        __m512i freq_start = _mm512_i32gather_epi32(slot, base, 8);
+        __m512i sym = _mm512_i32gather_epi32(slot, base + 1, 8);
+        __m512i freq = _mm512_and_si512(freq_start, low16);
+        __m512i start = _mm512_srli_epi32(freq_start, 16);
+
+        // x = freq * (x >> prob_bits) + slot - start
+        x = _mm512_add_epi32(_mm512_mullo_epi32(freq, _mm512_srl_epi32(x, shift)), _mm512_sub_epi32(slot, start));
+        _mm512_storeu_si512(out + i, sym);
+
+        // renormalize the lanes below L, the lowest such lane takes the word right below the cursor
+        __mmask16 m = _mm512_cmplt_epu32_mask(x, lower_bound);
+        if (m) {
+            __m512i words = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) (ptr - 16)));
+            __m512i expanded = _mm512_maskz_expand_epi32(m, _mm512_permutexvar_epi32(reverse, words));
+            x = _mm512_mask_or_epi32(x, m, _mm512_slli_epi32(x, 16), expanded);
+            ptr -= __builtin_popcount(m);
+        }
+    }
+    _mm512_storeu_si512(states, x);
+
+    *pptr = ptr;
+    return i;
+}
+
+#endif
+
+template <uint32_t LANES>
+static const uint16_t* wide_decode(uint32_t* states, const uint16_t* begin, const uint16_t* end,
+                                   const rANSDecSlot* slots, uint32_t prob_bits, size_t n, uint32_t* out)
+{
+    const uint16_t* ptr = end;
+    size_t full = n - n % LANES;
+    size_t i = 0;
+
+#if defined(__GNUC__) && defined(__AVX512F__)
+    if (LANES == 16) i = wide_decode_avx512(states, &ptr, begin, slots, prob_bits, i, full, out);
+#endif
+#if defined(__GNUC__) && defined(__AVX2__)
+    if (LANES == 8) i = wide_decode_avx2(states, &ptr, begin, slots, prob_bits, i, full, out);
+#endif
+    if (!wide_decode_scalar<LANES>(states, &ptr, begin, slots, prob_bits, i, full, out)) return nullptr;
+
+    for (i = full; i < n; i++) {
+        if (!wide_get(&states[i - full], &ptr, begin, slots, prob_bits, out + i)) return nullptr;
+    }
+
+    return ptr;
+}
+
+bool rANSWideDecode(const uint32_t* data, size_t size, const rANSModel& model, size_t n, uint32_t* out)
+{
+    const rANSDecSlot* slots = model.get_slots();
+    if (!slots || model.get_prob_bits() > RANS_WIDE_MAX_BITS) return false;
+    if (size < 2 || !RANS_FORMAT_IS(data[0], RANS_FORMAT_WIDE)) return false;
+
+    // the lane count sizes the copy of the states below, anything but 8 or 16 is a corrupt header
+    uint32_t lanes = data[0] & 0xff;
+    if (lanes != 8 && lanes != 16) return false;
+    size_t num_words = data[1];
+    if (size < 2 + lanes + (num_words + 1) / 2) return false;
+
+    uint32_t states[16];
+    memcpy(states, data + 2, lanes * sizeof(uint32_t));
+
+    const uint16_t* begin = (const uint16_t*) (data + 2 + lanes);
+    const uint16_t* end = begin + num_words;
+    if (lanes == 16) {
+        end = wide_decode<16>(states, begin, end, slots, model.get_prob_bits(), n, out);
+    } else {
+        end = wide_decode<8>(states, begin, end, slots, model.get_prob_bits(), n, out);
+    }
+
+    return end == begin;
+}
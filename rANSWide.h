@@ -0,0 +1,56 @@
+//
+// Wide-lane rANS kernel for static models.
+//
+
+#ifndef CLIONSCRATCHPAD_RANSWIDE_H
+#define CLIONSCRATCHPAD_RANSWIDE_H
+
+#include "rANSModel.h"
+#include "rANSFormat.h"
+#include <vector>
+#include <cstddef>
+
+// Lower bound of the normalization interval of the 32-bit lane states. States live in [L, 2^32) and renormalize
+// by 16 bits at a time, so a lane state fits a 32-bit vector element.
+#define RANS_WIDE_L (1u << 16)
+
+// Largest prob_bits the 32-bit lane states support.
+#define RANS_WIDE_MAX_BITS 16
+
+/**
+ * @brief Encodes an array of symbols with lanes independent 32-bit rANS states.
+ *
+ * @details Symbol i is coded with lane i % lanes. The lanes renormalize by 16-bit words, which are written in the
+ * order the decoder consumes them, so that a vectorized decoder can serve all lanes of a step with one load. The
+ * stream layout is
+ *
+ *     marker word (RANS_FORMAT_WIDE, lanes)
+ *     number of 16-bit payload words
+ *     lanes final states
+ *     payload, 16-bit words packed into 32-bit words
+ *
+ * @param[in] syms Array of n symbols to encode.
+ * @param[in] n Number of symbols.
+ * @param[in] model Model to encode with, at most RANS_WIDE_MAX_BITS prob_bits.
+ * @param[in] lanes Number of lanes, 8 or 16.
+ * @param[out] out Receives the encoded stream.
+ */
+void rANSWideEncode(const uint32_t* syms, size_t n, const rANSModel& model, uint32_t lanes, std::vector<uint32_t>& out);
+
+/**
+ * @brief Decodes a stream produced by rANSWideEncode.
+ *
+ * @details 8-lane streams are decoded with AVX2 and 16-lane streams with AVX-512 when the build targets these
+ * instruction sets, using gathers into the model's lookup table and vectorized renormalization. Otherwise a scalar
+ * decoder is used. All decoders give the same result.
+ *
+ * @param[in] data The encoded stream.
+ * @param[in] size Size of the stream in words.
+ * @param[in] model Model to decode with. Must have a lookup table, see rANSModel::get_slots.
+ * @param[in] n Number of symbols to decode.
+ * @param[out] out Preallocated array of n symbols receiving the decoded text in original order.
+ * @return false if the stream is malformed or was not consumed exactly.
+ */
+bool rANSWideDecode(const uint32_t* data, size_t size, const rANSModel& model, size_t n, uint32_t* out);
+
+#endif //CLIONSCRATCHPAD_RANSWIDE_H
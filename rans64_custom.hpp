@@ -111,6 +111,27 @@ static inline void Rans64EncPut(uint64_t* r, std::vector<uint32_t>& vec, uint32_
     *r = ((x / freq) << scale_bits) + (x % freq) + start;
 }
 
+// Same as the std::vector overload, but writes the word to *pptr and moves the
+// cursor forwards. Gives the same buffer layout as the std::vector encoder; the
+// caller must make sure there is room for one more word.
+static inline void Rans64EncPutFwd(Rans64State* r, uint32_t** pptr, uint32_t start, uint32_t freq, uint32_t scale_bits)
+{
+    Rans64Assert(freq != 0);
+
+    // renormalize (never needs to loop)
+    uint64_t x = *r;
+    uint64_t x_max = ((RANS64_L >> scale_bits) << 32) * freq; // this turns into a shift.
+    if (x >= x_max) {
+        **pptr = (uint32_t) x;
+        *pptr += 1;
+        x >>= 32;
+        Rans64Assert(x < x_max);
+    }
+
+    // x = C(s,x)
+    *r = ((x / freq) << scale_bits) + (x % freq) + start;
+}
+
 // Flushes the rANS encoder.
 static inline void Rans64EncFlush(Rans64State* r, uint32_t** pptr)
 {
@@ -204,6 +225,92 @@ static inline void Rans64DecAdvance(Rans64State* r, std::vector<uint32_t>& vec,
     *r = x;
 }
 
+// Buffers written by the std::vector encoder are read from the end towards
+// the start. These variants take a cursor *pptr pointing one past the next
+// word to read, so they can decode such a buffer in place.
+
+// Initializes a rANS decoder, reading backwards.
+static inline void Rans64DecInitRev(Rans64State* r, const uint32_t** pptr)
+{
+    uint64_t x;
+
+    x  = (uint64_t) (*pptr)[-1] << 0;
+    x |= (uint64_t) (*pptr)[-2] << 32;
+    *pptr -= 2;
+    *r = x;
+}
+
+// Advances in the bit stream by "popping" a single symbol, reading backwards.
+static inline void Rans64DecAdvanceRev(Rans64State* r, const uint32_t** pptr, uint32_t start, uint32_t freq, uint32_t scale_bits)
+{
+    uint64_t mask = (1ull << scale_bits) - 1;
+
+    // s, x = D(x)
+    uint64_t x = *r;
+    x = freq * (x >> scale_bits) + (x & mask) - start;
+
+    // renormalize
+    if (x < RANS64_L) {
+        *pptr -= 1;
+        x = (x << 32) | **pptr;
+        Rans64Assert(x >= RANS64_L);
+    }
+
+    *r = x;
+}
+
+// Renormalize, reading backwards.
+static inline void Rans64DecRenormRev(Rans64State* r, const uint32_t** pptr)
+{
+    // renormalize
+    uint64_t x = *r;
+    if (x < RANS64_L) {
+        *pptr -= 1;
+        x = (x << 32) | **pptr;
+        Rans64Assert(x >= RANS64_L);
+    }
+
+    *r = x;
+}
+
+// Like Rans64DecAdvanceRev, but never reads a word before "begin". Returns
+// false, leaving the state and the cursor untouched, when the symbol would
+// need one: the stream is truncated or holds fewer symbols than asked for.
+static inline bool Rans64DecAdvanceRevBounded(Rans64State* r, const uint32_t** pptr, const uint32_t* begin,
+                                              uint32_t start, uint32_t freq, uint32_t scale_bits)
+{
+    uint64_t mask = (1ull << scale_bits) - 1;
+
+    // s, x = D(x)
+    uint64_t x = *r;
+    x = freq * (x >> scale_bits) + (x & mask) - start;
+
+    // renormalize
+    if (x < RANS64_L) {
+        if (*pptr <= begin) return false;
+        *pptr -= 1;
+        x = (x << 32) | **pptr;
+    }
+
+    *r = x;
+    return true;
+}
+
+// Like Rans64DecRenormRev, but returns false instead of reading a word before "begin".
+static inline bool Rans64DecRenormRevBounded(Rans64State* r, const uint32_t** pptr, const uint32_t* begin)
+{
+    // renormalize
+    uint64_t x = *r;
+    if (x < RANS64_L) {
+        if (*pptr <= begin) return false;
+        *pptr -= 1;
+        x = (x << 32) | **pptr;
+    }
+
+    *r = x;
+    return true;
+}
+
 // --------------------------------------------------------------------------
 
 // That's all you need for a full encoder; below here are some utility
@@ -340,6 +447,42 @@ static inline void Rans64EncPutSymbol(Rans64State* r, uint32_t** pptr, Rans64Enc
     *r = x + sym->bias + q * sym->cmpl_freq;
 }
 
+static inline void Rans64EncPutSymbol(Rans64State* r, std::vector<uint32_t>& vec, Rans64EncSymbol const* sym, uint32_t scale_bits)
+{
+    Rans64Assert(sym->freq != 0); // can't encode symbol with freq=0
+
+    // renormalize
+    uint64_t x = *r;
+    uint64_t x_max = ((RANS64_L >> scale_bits) << 32) * sym->freq; // turns into a shift
+    if (x >= x_max) {
+        vec.push_back((uint32_t) x);
+        x >>= 32;
+    }
+
+    // x = C(s,x)
+    uint64_t q = Rans64MulHi(x, sym->rcp_freq) >> sym->rcp_shift;
+    *r = x + sym->bias + q * sym->cmpl_freq;
+}
+
+// Encodes a given symbol, writing forwards like Rans64EncPutFwd.
+static inline void Rans64EncPutSymbolFwd(Rans64State* r, uint32_t** pptr, Rans64EncSymbol const* sym, uint32_t scale_bits)
+{
+    Rans64Assert(sym->freq != 0); // can't encode symbol with freq=0
+
+    // renormalize
+    uint64_t x = *r;
+    uint64_t x_max = ((RANS64_L >> scale_bits) << 32) * sym->freq; // turns into a shift
+    if (x >= x_max) {
+        **pptr = (uint32_t) x;
+        *pptr += 1;
+        x >>= 32;
+    }
+
+    // x = C(s,x)
+    uint64_t q = Rans64MulHi(x, sym->rcp_freq) >> sym->rcp_shift;
+    *r = x + sym->bias + q * sym->cmpl_freq;
+}
+
 // Equivalent to RansDecAdvance that takes a symbol.
 static inline void Rans64DecAdvanceSymbol(Rans64State* r, uint32_t** pptr, Rans64DecSymbol const* sym, uint32_t scale_bits)
 {
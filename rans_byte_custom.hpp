@@ -0,0 +1,120 @@
+// Simple byte-aligned rANS encoder/decoder - public domain - Fabian 'ryg' Giesen 2014
+//
+// Not intended to be "industrial strength"; just meant to illustrate the
+// general idea.
+//
+// This version keeps a 32-bit state and renormalizes a byte at a time, so
+// the stream has byte granularity and the final state takes 4 bytes. It is
+// adapted to the buffer layout of rans64_custom.hpp: the encoder appends
+// bytes going forwards and the decoder reads them backwards from the end.
+
+#ifndef RANS_BYTE_HEADER
+#define RANS_BYTE_HEADER
+
+#include <stdint.h>
+
+#ifdef assert
+#define RansAssert assert
+#else
+#define RansAssert(x)
+#endif
+
+// L ('l' in the paper) is the lower bound of our normalization interval.
+// Between this and our byte-aligned emission, we use 31 (not 32!) bits.
+// This is done intentionally because exact reciprocals for 31-bit uints
+// fit in 32-bit uints: this permits some optimizations during encoding.
+#define RANS_BYTE_L (1u << 23)  // lower bound of our normalization interval
+
+// State for a rANS encoder. Yep, that's all there is to it.
+typedef uint32_t RansState;
+
+// Initialize a rANS encoder.
+static inline void RansEncInit(RansState* r)
+{
+    *r = RANS_BYTE_L;
+}
+
+// Encodes a single symbol with range start "start" and frequency "freq".
+// All frequencies are assumed to sum to "1 << scale_bits". The bytes are
+// written forwards at *pptr, which is updated; with scale_bits <= 16 a
+// symbol writes at most 2 bytes.
+//
+// NOTE: With rANS, you need to encode symbols in *reverse order*, and the
+// decoder reads the bytes from the end of the buffer towards its start.
+static inline void RansEncPutFwd(RansState* r, uint8_t** pptr, uint32_t start, uint32_t freq, uint32_t scale_bits)
+{
+    RansAssert(freq != 0);
+
+    // renormalize
+    uint32_t x = *r;
+    uint32_t x_max = ((RANS_BYTE_L >> scale_bits) << 8) * freq; // this turns into a shift.
+    while (x >= x_max) {
+        **pptr = (uint8_t) (x & 0xff);
+        *pptr += 1;
+        x >>= 8;
+    }
+
+    // x = C(s,x)
+    *r = ((x / freq) << scale_bits) + (x % freq) + start;
+}
+
+// Flushes the rANS encoder, appending the 4 bytes of the state so that the
+// decoder reads its most significant byte first.
+static inline void RansEncFlushFwd(RansState* r, uint8_t** pptr)
+{
+    uint32_t x = *r;
+    uint8_t* ptr = *pptr;
+
+    ptr[0] = (uint8_t) (x >> 0);
+    ptr[1] = (uint8_t) (x >> 8);
+    ptr[2] = (uint8_t) (x >> 16);
+    ptr[3] = (uint8_t) (x >> 24);
+    *pptr = ptr + 4;
+}
+
+// Initializes a rANS decoder, reading backwards from *pptr.
+static inline void RansDecInitRev(RansState* r, const uint8_t** pptr)
+{
+    const uint8_t* ptr = *pptr;
+
+    uint32_t x = (uint32_t) ptr[-1] << 24;
+    x |= (uint32_t) ptr[-2] << 16;
+    x |= (uint32_t) ptr[-3] << 8;
+    x |= (uint32_t) ptr[-4] << 0;
+    *pptr = ptr - 4;
+    *r = x;
+}
+
+// Returns the current cumulative frequency (map it to a symbol yourself!)
+static inline uint32_t RansDecGet(RansState* r, uint32_t scale_bits)
+{
+    return *r & ((1u << scale_bits) - 1);
+}
+
+// Advances in the bit stream by "popping" a single symbol with range start
+// "start" and frequency "freq", reading backwards. Bytes before "begin" are
+// never read: returns false, leaving the state and the cursor untouched, when
+// the symbol would need one, i.e. the stream is truncated or holds fewer
+// symbols than asked for.
+static inline bool RansDecAdvanceRev(RansState* r, const uint8_t** pptr, const uint8_t* begin, uint32_t start,
+                                     uint32_t freq, uint32_t scale_bits)
+{
+    uint32_t mask = (1u << scale_bits) - 1;
+
+    // s, x = D(x)
+    uint32_t x = *r;
+    x = freq * (x >> scale_bits) + (x & mask) - start;
+
+    // renormalize
+    const uint8_t* ptr = *pptr;
+    while (x < RANS_BYTE_L) {
+        if (ptr <= begin) return false;
+        x = (x << 8) | *--ptr;
+    }
+    *pptr = ptr;
+
+    *r = x;
+    return true;
+}
+
+#endif // RANS_BYTE_HEADER